@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "arrival_queue.h"
+
+// MPMC queue functions
+void initMpmcQueue(MpmcQueue *q) {
+    q->ring.clear();
+    SDL_AtomicSet(&q->dropped, 0);
+    SDL_AtomicSet(&q->retries, 0);
+}
+
+bool mpmcPush(MpmcQueue *q, const Vehicle *vehicle) {
+    return q->ring.push(*vehicle);
+}
+
+bool mpmcPop(MpmcQueue *q, Vehicle *vehicle) {
+    return q->ring.pop(*vehicle);
+}
+
+// Arrival generator functions
+bool submitArrival(ArrivalGenerator *generator, const Vehicle *vehicle) {
+    MpmcQueue *lane = &generator->lanes[vehicle->direction];
+
+    for (int attempt = 0; attempt <= ARRIVAL_PUSH_RETRIES; attempt++) {
+        if (mpmcPush(lane, vehicle)) {
+            return true;
+        }
+        SDL_AtomicAdd(&lane->retries, 1);
+        SDL_Delay(1);
+    }
+
+    SDL_AtomicAdd(&lane->dropped, 1);
+    return false;
+}
+
+// Pops the next arrival for the lane if it is due by now
+bool takeArrival(ArrivalGenerator *generator, int lane, Uint32 now, Vehicle *vehicle) {
+    if (!generator->hasPending[lane]) {
+        if (!mpmcPop(&generator->lanes[lane], &generator->pending[lane])) {
+            return false;
+        }
+        SDL_AtomicAdd(&generator->taken, 1);
+        generator->hasPending[lane] = true;
+    }
+
+    if (generator->pending[lane].spawnTime > now) {
+        return false;
+    }
+
+    *vehicle = generator->pending[lane];
+    generator->hasPending[lane] = false;
+    return true;
+}
+
+// Only blocks if the simulation has outrun the arrival schedule, which the lookahead
+// prevents at real-time speed; headless runs wait here instead of skipping arrivals
+void waitForArrivals(ArrivalGenerator *generator, Uint32 now) {
+    while ((Uint32)SDL_AtomicGet(&generator->scheduledUntil) < now) {
+        SDL_Delay(0);
+    }
+}
+
+static int arrivalThread(void *data) {
+    ArrivalGenerator *generator = (ArrivalGenerator *)data;
+    // Accumulated in double so short intervals keep their fraction; spawn times round down
+    double nextSpawn = generator->spawnInterval;
+    int pushed = 0;
+
+    do {
+        Uint32 horizon = getSimulationTime() + ARRIVAL_LOOKAHEAD_MS;
+
+        // Fewer outstanding than one ring holds, so whichever lanes they go to, they fit
+        while ((Uint32)nextSpawn <= horizon &&
+               pushed - SDL_AtomicGet(&generator->taken) < ARRIVAL_QUEUE_CAPACITY) {
+            Direction spawnDirection = (Direction)rngBelow(&simulationRandom.intersection, 4);
+            Vehicle vehicle;
+            initVehicle(&vehicle, spawnDirection);
+            vehicle.spawnTime = (Uint32)nextSpawn;
+
+            submitArrival(generator, &vehicle);
+            pushed++;
+            nextSpawn += generator->spawnInterval;
+        }
+
+        SDL_AtomicSet(&generator->scheduledUntil, (int)((Uint32)nextSpawn - 1));
+    } while (SDL_SemWaitTimeout(generator->stopSignal, ARRIVAL_POLL_MS) == SDL_MUTEX_TIMEDOUT);
+
+    return 0;
+}
+
+bool startArrivalGenerator(ArrivalGenerator *generator, double spawnInterval) {
+    for (int i = 0; i < 4; i++) {
+        initMpmcQueue(&generator->lanes[i]);
+        generator->hasPending[i] = false;
+    }
+    // Also keeps the first arrival after time 0, which scheduledUntil relies on
+    generator->spawnInterval = spawnInterval > ARRIVAL_MIN_INTERVAL_MS ? spawnInterval : ARRIVAL_MIN_INTERVAL_MS;
+    SDL_AtomicSet(&generator->scheduledUntil, 0);
+    SDL_AtomicSet(&generator->taken, 0);
+
+    generator->stopSignal = SDL_CreateSemaphore(0);
+    if (!generator->stopSignal) {
+        printf("Failed to create arrival stop signal: %s\n", SDL_GetError());
+        return false;
+    }
+
+    generator->thread = SDL_CreateThread(arrivalThread, "arrivals", generator);
+    if (!generator->thread) {
+        printf("Failed to start arrival thread: %s\n", SDL_GetError());
+        SDL_DestroySemaphore(generator->stopSignal);
+        return false;
+    }
+
+    return true;
+}
+
+void stopArrivalGenerator(ArrivalGenerator *generator) {
+    SDL_SemPost(generator->stopSignal);
+    SDL_WaitThread(generator->thread, NULL);
+    SDL_DestroySemaphore(generator->stopSignal);
+    generator->thread = NULL;
+    generator->stopSignal = NULL;
+}
@@ -0,0 +1,49 @@
+#ifndef ARRIVAL_QUEUE_H
+#define ARRIVAL_QUEUE_H
+
+#include "traffic_simulation.h"
+
+#include "queue.hpp"
+
+#define ARRIVAL_QUEUE_CAPACITY 256  // Must be a power of two
+#define ARRIVAL_PUSH_RETRIES 3       // Extra attempts before an arrival is dropped
+#define ARRIVAL_LOOKAHEAD_MS 10000   // How far ahead of simulated time arrivals are scheduled
+#define ARRIVAL_POLL_MS 2            // Arrival thread wake-up period (wall clock)
+#define ARRIVAL_MIN_INTERVAL_MS 1.0  // Closest spacing of arrivals, so a step's worth always fits in a ring
+
+// Bounded MPMC arrival ring with backpressure counters
+typedef struct {
+    sim::Queue<Vehicle, ARRIVAL_QUEUE_CAPACITY, sim::FixedCapacity, sim::Mpmc> ring;
+    SDL_atomic_t dropped;   // Arrivals abandoned after every retry found the queue full
+    SDL_atomic_t retries;   // Push attempts that found the queue full
+} MpmcQueue;
+
+// Arrival front for the lanes: any number of sources push, the simulation pops.
+// Arrivals carry their spawnTime and are scheduled ahead of the simulation, so the
+// simulation can admit each one on exactly the step it is due. The schedule runs at most
+// a ring's worth of arrivals ahead, so the generator never finds a ring full and never
+// drops one, and a seed always gives the same arrivals whatever the thread timing.
+typedef struct {
+    MpmcQueue lanes[4];
+    double spawnInterval;         // Simulated ms between arrivals, may be fractional
+    SDL_Thread* thread;
+    SDL_sem* stopSignal;
+    SDL_atomic_t scheduledUntil;  // Every arrival due up to this time has been pushed
+    SDL_atomic_t taken;           // Arrivals the simulation has popped
+    Vehicle pending[4];           // Consumer side: popped but not yet due
+    bool hasPending[4];
+} ArrivalGenerator;
+
+// MPMC queue functions (lock-free, bounded)
+void initMpmcQueue(MpmcQueue* q);
+bool mpmcPush(MpmcQueue* q, const Vehicle* vehicle);
+bool mpmcPop(MpmcQueue* q, Vehicle* vehicle);
+
+// Arrival generator functions
+bool submitArrival(ArrivalGenerator* generator, const Vehicle* vehicle);
+bool takeArrival(ArrivalGenerator* generator, int lane, Uint32 now, Vehicle* vehicle);
+void waitForArrivals(ArrivalGenerator* generator, Uint32 now);
+bool startArrivalGenerator(ArrivalGenerator* generator, double spawnInterval);
+void stopArrivalGenerator(ArrivalGenerator* generator);
+
+#endif
@@ -0,0 +1,153 @@
+#include <string.h>
+#include "calendar_queue.h"
+
+static Uint64 dayOf(const CalendarQueue *cq, double time) {
+    return (Uint64)(time / cq->width);
+}
+
+static bool comesBefore(const CalendarEvent *a, const CalendarEvent *b) {
+    return a->time < b->time || (a->time == b->time && a->sequence < b->sequence);
+}
+
+static void insertNode(CalendarQueue *cq, CalendarEvent *node) {
+    CalendarEvent **link = &cq->buckets[dayOf(cq, node->time) % cq->bucketCount];
+    while (*link && !comesBefore(node, *link)) {
+        link = &(*link)->next;
+    }
+    node->next = *link;
+    *link = node;
+}
+
+static CalendarEvent *popNode(CalendarQueue *cq) {
+    if (cq->size == 0) return NULL;
+
+    // Walk one year of days from the last event; the first head due on its day is the minimum
+    Uint64 day = cq->day;
+    for (int n = 0; n < cq->bucketCount; n++, day++) {
+        CalendarEvent **bucket = &cq->buckets[day % cq->bucketCount];
+        if (*bucket && dayOf(cq, (*bucket)->time) <= day) {
+            CalendarEvent *node = *bucket;
+            *bucket = node->next;
+            cq->day = day;
+            cq->size--;
+            return node;
+        }
+    }
+
+    // Nothing within a year: jump straight to the earliest head
+    int earliest = -1;
+    for (int i = 0; i < cq->bucketCount; i++) {
+        if (cq->buckets[i] && (earliest < 0 || comesBefore(cq->buckets[i], cq->buckets[earliest]))) {
+            earliest = i;
+        }
+    }
+    CalendarEvent *node = cq->buckets[earliest];
+    cq->buckets[earliest] = node->next;
+    cq->day = dayOf(cq, node->time);
+    cq->size--;
+    return node;
+}
+
+// Three times the mean gap between the soonest events, ignoring outliers, per Brown
+static double estimateWidth(CalendarQueue *cq) {
+    CalendarEvent *sample[CALENDAR_WIDTH_SAMPLE];
+    Uint64 day = cq->day;
+    int count = 0;
+    while (count < CALENDAR_WIDTH_SAMPLE && cq->size > 0) {
+        sample[count++] = popNode(cq);
+    }
+
+    double width = cq->width;
+    if (count >= 2) {
+        double mean = (sample[count - 1]->time - sample[0]->time) / (count - 1);
+        double total = 0.0;
+        int gaps = 0;
+        for (int i = 1; i < count; i++) {
+            double gap = sample[i]->time - sample[i - 1]->time;
+            if (gap <= 2.0 * mean) {
+                total += gap;
+                gaps++;
+            }
+        }
+        if (gaps > 0 && total > 0.0) {
+            width = 3.0 * total / gaps;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        insertNode(cq, sample[i]);
+        cq->size++;
+    }
+    cq->day = day;
+    return width;
+}
+
+static void resizeCalendar(CalendarQueue *cq, int bucketCount) {
+    double now = cq->day * cq->width;
+    double width = estimateWidth(cq);
+
+    CalendarEvent **old = cq->buckets;
+    int oldCount = cq->bucketCount;
+
+    cq->buckets = (CalendarEvent **)simAlloc(sizeof(CalendarEvent *) * bucketCount);
+    memset(cq->buckets, 0, sizeof(CalendarEvent *) * bucketCount);
+    cq->bucketCount = bucketCount;
+    cq->width = width;
+    cq->day = dayOf(cq, now);
+
+    for (int i = 0; i < oldCount; i++) {
+        CalendarEvent *node = old[i];
+        while (node) {
+            CalendarEvent *next = node->next;
+            insertNode(cq, node);
+            node = next;
+        }
+    }
+    simFree(old);
+}
+
+void initCalendarQueue(CalendarQueue *cq, double width) {
+    cq->bucketCount = CALENDAR_MIN_BUCKETS;
+    cq->buckets = (CalendarEvent **)simAlloc(sizeof(CalendarEvent *) * cq->bucketCount);
+    memset(cq->buckets, 0, sizeof(CalendarEvent *) * cq->bucketCount);
+    cq->width = width;
+    cq->day = 0;
+    cq->size = 0;
+    cq->nextSequence = 0;
+    initPool(&cq->nodes, sizeof(CalendarEvent), POOL_SLAB_BLOCKS);
+}
+
+void freeCalendarQueue(CalendarQueue *cq) {
+    simFree(cq->buckets);
+    destroyPool(&cq->nodes);
+    cq->buckets = NULL;
+    cq->bucketCount = 0;
+    cq->size = 0;
+}
+
+// Events must not be scheduled before the last one popped
+void calendarSchedule(CalendarQueue *cq, const CalendarEvent *event) {
+    CalendarEvent *node = (CalendarEvent *)poolAlloc(&cq->nodes);
+    *node = *event;
+    node->sequence = cq->nextSequence++;
+    insertNode(cq, node);
+    cq->size++;
+
+    if (cq->size > 2 * cq->bucketCount) {
+        resizeCalendar(cq, cq->bucketCount * 2);
+    }
+}
+
+bool calendarPop(CalendarQueue *cq, CalendarEvent *event) {
+    CalendarEvent *node = popNode(cq);
+    if (!node) return false;
+
+    *event = *node;
+    event->next = NULL;
+    poolFree(&cq->nodes, node);
+
+    if (cq->bucketCount > CALENDAR_MIN_BUCKETS && cq->size < cq->bucketCount / 2) {
+        resizeCalendar(cq, cq->bucketCount / 2);
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef CALENDAR_QUEUE_H
+#define CALENDAR_QUEUE_H
+
+#include <SDL2/SDL_stdinc.h>
+#include <stdbool.h>
+#include "pool.h"
+
+#define CALENDAR_MIN_BUCKETS 16
+#define CALENDAR_WIDTH_SAMPLE 25  // Soonest events sampled to pick a bucket width on resize
+
+// Scheduled event. The payload fields after sequence belong to the caller.
+typedef struct CalendarEvent {
+    double time;
+    Uint32 sequence;        // Events at the same time pop in the order they were scheduled
+    int type;
+    int lane;
+    Uint8 turnDirection;
+    double stamp;           // Caller-defined time carried with the event
+    struct CalendarEvent* next;
+} CalendarEvent;
+
+// Calendar queue (Brown, 1988): buckets are the days of a year, each `width` long, and an
+// event goes into the day its time falls on, kept sorted. Popping walks forward day by day
+// from the last event, so schedule and pop are O(1) on average when the width matches
+// the typical gap between events. The bucket count doubles or halves with the size.
+typedef struct {
+    CalendarEvent** buckets;
+    int bucketCount;
+    double width;
+    Uint64 day;             // Absolute day of the last popped event
+    int size;
+    Uint32 nextSequence;
+    Pool nodes;
+} CalendarQueue;
+
+// Calendar queue functions
+void initCalendarQueue(CalendarQueue* cq, double width);
+void freeCalendarQueue(CalendarQueue* cq);
+void calendarSchedule(CalendarQueue* cq, const CalendarEvent* event);
+bool calendarPop(CalendarQueue* cq, CalendarEvent* event);
+
+#endif
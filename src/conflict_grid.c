@@ -0,0 +1,159 @@
+#include <string.h>
+#include "conflict_grid.h"
+
+typedef struct {
+    int firstColumn, lastColumn, firstRow, lastRow;
+} CellRange;
+
+// Cells under [left, right) x [top, bottom), clipped to the box. False if it misses the box.
+static bool cellsUnder(float left, float top, float right, float bottom, CellRange *range) {
+    float boxRight = CONFLICT_BOX_LEFT + CONFLICT_BOX_SIZE;
+    float boxBottom = CONFLICT_BOX_TOP + CONFLICT_BOX_SIZE;
+    if (right <= CONFLICT_BOX_LEFT || left >= boxRight || bottom <= CONFLICT_BOX_TOP || top >= boxBottom) {
+        return false;
+    }
+
+    range->firstColumn = left <= CONFLICT_BOX_LEFT ? 0 : (int)((left - CONFLICT_BOX_LEFT) / CONFLICT_CELL_SIZE);
+    range->firstRow = top <= CONFLICT_BOX_TOP ? 0 : (int)((top - CONFLICT_BOX_TOP) / CONFLICT_CELL_SIZE);
+    range->lastColumn = right >= boxRight ? CONFLICT_CELLS_PER_SIDE - 1
+                                          : (int)((right - CONFLICT_BOX_LEFT) / CONFLICT_CELL_SIZE);
+    range->lastRow = bottom >= boxBottom ? CONFLICT_CELLS_PER_SIDE - 1
+                                         : (int)((bottom - CONFLICT_BOX_TOP) / CONFLICT_CELL_SIZE);
+    return true;
+}
+
+// Both buffers only ever grow, keeping their high-water size
+void reserveConflictGrid(ConflictGrid *grid, int occupants, int entries) {
+    if (occupants > grid->occupantCapacity) {
+        int capacity = grid->occupantCapacity ? grid->occupantCapacity : CONFLICT_INITIAL_OCCUPANTS;
+        while (capacity < occupants) capacity *= 2;
+        BoxOccupant *grown = (BoxOccupant *)simAlloc(sizeof(BoxOccupant) * capacity);
+        if (grid->occupantCount > 0) {
+            memcpy(grown, grid->occupants, sizeof(BoxOccupant) * grid->occupantCount);
+        }
+        simFree(grid->occupants);
+        grid->occupants = grown;
+        grid->occupantCapacity = capacity;
+    }
+
+    if (entries > grid->entryCapacity) {
+        int capacity = grid->entryCapacity ? grid->entryCapacity : CONFLICT_INITIAL_ENTRIES;
+        while (capacity < entries) capacity *= 2;
+        simFree(grid->cellEntries);
+        grid->cellEntries = (int *)simAlloc(sizeof(int) * capacity);
+        grid->entryCapacity = capacity;
+    }
+}
+
+static void addOccupant(ConflictGrid *grid, const BoxOccupant *occupant) {
+    if (grid->occupantCount == grid->occupantCapacity) {
+        reserveConflictGrid(grid, grid->occupantCount + 1, 0);
+    }
+    grid->occupants[grid->occupantCount++] = *occupant;
+}
+
+// Counting sort into cells: one pass to collect and count, one to place. O(vehicles).
+void buildConflictGrid(ConflictGrid *grid, Queue lanes[4]) {
+    int counts[CONFLICT_CELL_COUNT] = {0};
+    int entries = 0;
+    grid->occupantCount = 0;
+
+    for (int lane = 0; lane < 4; lane++) {
+        Queue *q = &lanes[lane];
+        for (int i = 0; i < q->size; i++) {
+            int slot = QUEUE_SLOT(q, i);
+            // Vehicles held at their stop line poke into the box but aren't crossing anything
+            if ((q->flags[slot] & (VEHICLE_ACTIVE | VEHICLE_STOPPED)) != VEHICLE_ACTIVE) continue;
+
+            const ApproachGeometry *approach = &APPROACHES[q->direction[slot]];
+            BoxOccupant occupant = {q->x[slot], q->y[slot], q->x[slot] + approach->width,
+                                    q->y[slot] + approach->height, q->direction[slot]};
+            CellRange range;
+            if (!cellsUnder(occupant.left, occupant.top, occupant.right, occupant.bottom, &range)) continue;
+
+            addOccupant(grid, &occupant);
+            for (int row = range.firstRow; row <= range.lastRow; row++) {
+                for (int column = range.firstColumn; column <= range.lastColumn; column++) {
+                    counts[row * CONFLICT_CELLS_PER_SIDE + column]++;
+                    entries++;
+                }
+            }
+        }
+    }
+
+    reserveConflictGrid(grid, 0, entries);
+
+    grid->cellStart[0] = 0;
+    for (int c = 0; c < CONFLICT_CELL_COUNT; c++) {
+        grid->cellStart[c + 1] = grid->cellStart[c] + counts[c];
+        counts[c] = grid->cellStart[c];  // Reused as the fill cursor
+    }
+
+    for (int o = 0; o < grid->occupantCount; o++) {
+        const BoxOccupant *occupant = &grid->occupants[o];
+        CellRange range;
+        cellsUnder(occupant->left, occupant->top, occupant->right, occupant->bottom, &range);
+        for (int row = range.firstRow; row <= range.lastRow; row++) {
+            for (int column = range.firstColumn; column <= range.lastColumn; column++) {
+                grid->cellEntries[counts[row * CONFLICT_CELLS_PER_SIDE + column]++] = o;
+            }
+        }
+    }
+}
+
+// True if a vehicle at (x, y) heading `direction` must wait before entering the box.
+// Moving vehicles already inside have right of way over crossing movements, and once inside
+// a vehicle never waits for crossing traffic, so two vehicles can't hold each other up.
+// Same-direction vehicles are left to the lane's leader check.
+bool hasCrossingConflict(const ConflictGrid *grid, float x, float y, Direction direction) {
+    if (grid->occupantCount == 0) return false;
+
+    const ApproachGeometry *approach = &APPROACHES[direction];
+    float left = x, top = y;
+    float right = x + approach->width, bottom = y + approach->height;
+
+    CellRange range;
+    if (cellsUnder(left, top, right, bottom, &range)) return false;  // Already inside
+
+    // Only vehicles about to enter wait
+    float ahead = CONFLICT_LOOKAHEAD;
+    if (!cellsUnder(left + approach->headingX * ahead, top + approach->headingY * ahead,
+                    right + approach->headingX * ahead, bottom + approach->headingY * ahead, &range)) {
+        return false;
+    }
+
+    // Its path across the box, widened so crossing traffic about to cut in counts too
+    if (approach->headingX != 0) {
+        if (approach->headingX > 0) right = CONFLICT_BOX_LEFT + CONFLICT_BOX_SIZE;
+        else left = CONFLICT_BOX_LEFT;
+        top -= CONFLICT_CLEARANCE;
+        bottom += CONFLICT_CLEARANCE;
+    } else {
+        if (approach->headingY > 0) bottom = CONFLICT_BOX_TOP + CONFLICT_BOX_SIZE;
+        else top = CONFLICT_BOX_TOP;
+        left -= CONFLICT_CLEARANCE;
+        right += CONFLICT_CLEARANCE;
+    }
+    cellsUnder(left, top, right, bottom, &range);
+
+    for (int row = range.firstRow; row <= range.lastRow; row++) {
+        for (int column = range.firstColumn; column <= range.lastColumn; column++) {
+            int cell = row * CONFLICT_CELLS_PER_SIDE + column;
+            for (int e = grid->cellStart[cell]; e < grid->cellStart[cell + 1]; e++) {
+                const BoxOccupant *other = &grid->occupants[grid->cellEntries[e]];
+                if (other->direction != direction &&
+                    other->left < right && other->right > left &&
+                    other->top < bottom && other->bottom > top) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void freeConflictGrid(ConflictGrid *grid) {
+    simFree(grid->occupants);
+    simFree(grid->cellEntries);
+    memset(grid, 0, sizeof(*grid));
+}
@@ -0,0 +1,43 @@
+#ifndef CONFLICT_GRID_H
+#define CONFLICT_GRID_H
+
+#include "traffic_simulation.h"
+
+// Uniform grid over the intersection box only: the one place where lanes cross.
+// Rebuilt every tick from the lanes before anyone moves, so queries during a
+// (parallel) lane update all see the same previous-tick occupants.
+#define CONFLICT_BOX_LEFT (INTERSECTION_X - LANE_WIDTH)
+#define CONFLICT_BOX_TOP (INTERSECTION_Y - LANE_WIDTH)
+#define CONFLICT_BOX_SIZE (2 * LANE_WIDTH)
+#define CONFLICT_CELL_SIZE 40
+#define CONFLICT_CELLS_PER_SIDE (CONFLICT_BOX_SIZE / CONFLICT_CELL_SIZE)
+#define CONFLICT_CELL_COUNT (CONFLICT_CELLS_PER_SIDE * CONFLICT_CELLS_PER_SIDE)
+#define CONFLICT_LOOKAHEAD 20.0f  // A vehicle this close to the box checks before entering
+#define CONFLICT_CLEARANCE 30.0f  // Side margin on its path, for crossing vehicles about to reach it
+#define CONFLICT_INITIAL_OCCUPANTS 16
+#define CONFLICT_INITIAL_ENTRIES 64
+
+// A moving vehicle overlapping the box
+typedef struct {
+    float left, top, right, bottom;
+    Uint8 direction;
+} BoxOccupant;
+
+// Occupants bucketed by cell in CSR form: cell c holds
+// occupants[cellEntries[cellStart[c] .. cellStart[c + 1])]
+typedef struct {
+    BoxOccupant* occupants;
+    int occupantCount;
+    int occupantCapacity;
+    int* cellEntries;         // An occupant appears once per cell it overlaps
+    int entryCapacity;
+    int cellStart[CONFLICT_CELL_COUNT + 1];
+} ConflictGrid;
+
+// Conflict grid functions
+void reserveConflictGrid(ConflictGrid* grid, int occupants, int entries);
+void buildConflictGrid(ConflictGrid* grid, Queue lanes[4]);
+bool hasCrossingConflict(const ConflictGrid* grid, float x, float y, Direction direction);
+void freeConflictGrid(ConflictGrid* grid);
+
+#endif
@@ -0,0 +1,214 @@
+#include <string.h>
+#include "event_simulation.h"
+#include "calendar_queue.h"
+#include "queue.hpp"
+
+typedef struct {
+    double stoppedAt;
+    Uint8 turnDirection;
+} StoppedVehicle;
+
+typedef struct {
+    sim::Queue<StoppedVehicle, 16, sim::Growable> line;  // Stopped at the line, front first
+    int approaching;        // Entered and not yet through the line: what the signal ranks
+    bool discharging;       // A LEADER_DEPARTS event is pending
+    double redSince;
+    double toStopLine;      // px from the entry point to the stop point
+    double straightExit;    // px from the stop point to off screen, straight on
+    double leftExit;        // px from the stop point to off screen, through a left turn
+} EventLane;
+
+typedef struct {
+    CalendarQueue calendar;
+    EventLane lanes[4];
+    Axis green;
+    PriorityQueue priority;
+    Uint32 spawnInterval;
+    double endTime;
+    EventStatistics* stats;
+} EventEngine;
+
+static double progressOf(const ApproachGeometry *a, float x, float y) {
+    return x * a->headingX + y * a->headingY;
+}
+
+// Vehicles stop where the frame engine's red-light window begins
+static void initLaneGeometry(EventLane *lane, Direction direction) {
+    const ApproachGeometry *a = &APPROACHES[direction];
+    const ApproachGeometry *exit = &APPROACHES[a->leftTurnExit];
+    double stopPoint = a->stopLine - STOP_WINDOW_BEFORE;
+
+    lane->toStopLine = stopPoint - progressOf(a, a->entryX, a->entryY);
+    lane->straightExit = a->exitLine - stopPoint;
+    // Turns are timed as if driven at cruise speed along both legs
+    lane->leftExit = (a->centerLine - stopPoint) + (exit->exitLine - exit->centerLine);
+}
+
+static bool isGreen(const EventEngine *engine, int lane) {
+    return APPROACHES[lane].axis == engine->green;
+}
+
+static void schedule(EventEngine *engine, double time, EventType type, int lane,
+                     Uint8 turnDirection, double stamp) {
+    CalendarEvent event;
+    memset(&event, 0, sizeof(event));
+    event.time = time;
+    event.type = type;
+    event.lane = lane;
+    event.turnDirection = turnDirection;
+    event.stamp = stamp;
+    calendarSchedule(&engine->calendar, &event);
+}
+
+static void depart(EventEngine *engine, int lane, Uint8 turnDirection, double now) {
+    EventLane *l = &engine->lanes[lane];
+    double distance = turnDirection == TURN_LEFT ? l->leftExit : l->straightExit;
+    l->approaching--;
+    schedule(engine, now + distance / EVENT_CRUISE_SPEED, EVENT_EXIT, lane, turnDirection, now);
+}
+
+// The head may go on green, or at any time if it turns left
+static bool headMayGo(const EventEngine *engine, int lane) {
+    const EventLane *l = &engine->lanes[lane];
+    return !l->line.empty() && (isGreen(engine, lane) || l->line[0].turnDirection == TURN_LEFT);
+}
+
+static void startDischarge(EventEngine *engine, int lane, double when) {
+    EventLane *l = &engine->lanes[lane];
+    if (!l->discharging && headMayGo(engine, lane)) {
+        l->discharging = true;
+        schedule(engine, when, EVENT_LEADER_DEPARTS, lane, 0, when);
+    }
+}
+
+static void onArrival(EventEngine *engine, double now) {
+    // Same draws in the same order as the arrival thread, so a seed gives the same vehicles
+    Direction direction = (Direction)rngBelow(&simulationRandom.intersection, 4);
+    Vehicle vehicle;
+    initVehicle(&vehicle, direction);
+
+    EventLane *l = &engine->lanes[direction];
+    l->approaching++;
+    engine->stats->totalVehicles++;
+    schedule(engine, now + l->toStopLine / EVENT_CRUISE_SPEED, EVENT_REACH_STOP_LINE,
+             direction, vehicle.turnDirection, now);
+
+    double next = now + engine->spawnInterval;
+    if (next <= engine->endTime) {
+        schedule(engine, next, EVENT_ARRIVAL, 0, 0, next);
+    }
+}
+
+static void onReachStopLine(EventEngine *engine, const CalendarEvent *event) {
+    EventLane *l = &engine->lanes[event->lane];
+    bool mayGo = isGreen(engine, event->lane) || event->turnDirection == TURN_LEFT;
+
+    if (l->line.empty() && mayGo) {
+        depart(engine, event->lane, event->turnDirection, event->time);
+        return;
+    }
+
+    StoppedVehicle stopped = {event->time, event->turnDirection};
+    l->line.push(stopped);
+    int waiting = (int)l->line.size();
+    if (waiting > engine->stats->longestLine[event->lane]) {
+        engine->stats->longestLine[event->lane] = waiting;
+    }
+    startDischarge(engine, event->lane, event->time);
+}
+
+static void onLeaderDeparts(EventEngine *engine, const CalendarEvent *event) {
+    EventLane *l = &engine->lanes[event->lane];
+    l->discharging = false;
+    if (!headMayGo(engine, event->lane)) return;
+
+    StoppedVehicle head = {0.0, 0};
+    l->line.pop(head);
+    engine->stats->vehiclesStopped++;
+    engine->stats->totalWaitMs += event->time - head.stoppedAt;
+    depart(engine, event->lane, head.turnDirection, event->time);
+
+    // The next one was stopped a spacing behind, so it crosses one headway later
+    startDischarge(engine, event->lane, event->time + EVENT_DISCHARGE_HEADWAY_MS);
+}
+
+// Same rule as updateTrafficLights: the most congested approach wins its axis
+static void onLightChange(EventEngine *engine, double now) {
+    for (int i = 0; i < 4; i++) {
+        float waited = 0.0f;
+        if (!isGreen(engine, i)) {
+            waited = (float)((now - engine->lanes[i].redSince) / 1000.0);
+        }
+        pqUpdate(&engine->priority, i, engine->lanes[i].approaching + SIGNAL_WAIT_WEIGHT * waited);
+    }
+
+    Axis green = APPROACHES[pqPeek(&engine->priority)].axis;
+    if (green != engine->green) {
+        for (int i = 0; i < 4; i++) {
+            if (isGreen(engine, i)) {
+                engine->lanes[i].redSince = now;
+            }
+        }
+        engine->green = green;
+        for (int i = 0; i < 4; i++) {
+            startDischarge(engine, i, now);
+        }
+    }
+
+    if (now + SIGNAL_PHASE_MS <= engine->endTime) {
+        schedule(engine, now + SIGNAL_PHASE_MS, EVENT_LIGHT_CHANGE, 0, 0, now);
+    }
+}
+
+void runEventSimulation(Uint32 durationMs, Uint32 spawnInterval, EventStatistics *stats) {
+    static EventEngine engine;
+    memset(stats, 0, sizeof(*stats));
+
+    initCalendarQueue(&engine.calendar, spawnInterval);
+    initPriorityQueue(&engine.priority, 4);
+    for (int i = 0; i < 4; i++) {
+        EventLane *l = &engine.lanes[i];
+        l->line.clear();
+        l->approaching = 0;
+        l->discharging = false;
+        l->redSince = 0.0;
+        initLaneGeometry(l, (Direction)i);
+        pqUpdate(&engine.priority, i, 0.0f);
+    }
+    engine.green = AXIS_EAST_WEST;  // As in initializeTrafficLights
+    engine.spawnInterval = spawnInterval;
+    engine.endTime = durationMs;
+    engine.stats = stats;
+
+    schedule(&engine, spawnInterval, EVENT_ARRIVAL, 0, 0, spawnInterval);
+    schedule(&engine, SIGNAL_PHASE_MS, EVENT_LIGHT_CHANGE, 0, 0, 0.0);
+
+    CalendarEvent event;
+    while (calendarPop(&engine.calendar, &event) && event.time <= engine.endTime) {
+        stats->eventsProcessed++;
+        switch (event.type) {
+            case EVENT_ARRIVAL:
+                onArrival(&engine, event.time);
+                break;
+            case EVENT_REACH_STOP_LINE:
+                onReachStopLine(&engine, &event);
+                break;
+            case EVENT_LIGHT_CHANGE:
+                onLightChange(&engine, event.time);
+                break;
+            case EVENT_LEADER_DEPARTS:
+                onLeaderDeparts(&engine, &event);
+                break;
+            case EVENT_EXIT:
+                stats->vehiclesPassed++;
+                break;
+        }
+    }
+
+    if (durationMs > 0) {
+        stats->vehiclesPerMinute = stats->vehiclesPassed / (durationMs / 60000.0f);
+    }
+
+    freeCalendarQueue(&engine.calendar);
+    freePriorityQueue(&engine.priority);
+}
@@ -15,20 +15,24 @@
 #endif
 
 #include "traffic_simulation.h"
+#include "queue.hpp"
 
 void writeVehicleToFile(FILE *file, Vehicle *vehicle) {
-    fprintf(file, "%f %f %d %d %d %d %d %d\n",
+    fprintf(file, "%f %f %d %d %d %d %f %d\n",
             vehicle->x, vehicle->y,
             vehicle->direction,
-            vehicle->type,
+            vehicleProfiles[vehicle->profile].type,
             vehicle->turnDirection,
-            vehicle->state,
+            (vehicle->flags & VEHICLE_STOPPED) ? STATE_STOPPED : STATE_MOVING,
             vehicle->speed,
-            vehicle->colorIndex);
+            vehicle->profile);
 }
 
 int main(int argc, char *argv[]) {
-    srand(time(NULL));
+    (void)argc;
+    (void)argv;
+    seedSimulationRandom(&simulationRandom, (Uint64)time(NULL));
+    initPool(&vehiclePool, sizeof(Vehicle), POOL_SLAB_BLOCKS);
     
     #ifdef _WIN32
         _mkdir("bin");  
@@ -48,34 +52,26 @@ int main(int argc, char *argv[]) {
     printf("Press Ctrl+C to stop\n\n");
 
     int vehicleCounter = 0;
-    const int MAX_CONCURRENT_VEHICLES = 15;  
+    const unsigned MAX_CONCURRENT_VEHICLES = 15;  
     const int MIN_SPACING = 150;  
 
-    Vehicle activeVehicles[MAX_CONCURRENT_VEHICLES] = {0};
-    int activeCount = 0;
+    // Most recent vehicles, oldest at the front
+    sim::Queue<Vehicle, MAX_CONCURRENT_VEHICLES> activeVehicles;
 
     while (1) {
       
-        Direction spawnDirection = (Direction)(rand() % 4);
+        Direction spawnDirection = (Direction)rngBelow(&simulationRandom.intersection, 4);
         Vehicle *newVehicle = createVehicle(spawnDirection);
         
         if (newVehicle) {
             
             bool canSpawn = true;
-            for (int i = 0; i < activeCount; i++) {
+            for (unsigned i = 0; i < activeVehicles.size(); i++) {
                 if (activeVehicles[i].direction == newVehicle->direction) {
                     
-                    float distance = 0;
-                    switch (newVehicle->direction) {
-                        case DIRECTION_NORTH:
-                        case DIRECTION_SOUTH:
-                            distance = fabs(newVehicle->y - activeVehicles[i].y);
-                            break;
-                        case DIRECTION_EAST:
-                        case DIRECTION_WEST:
-                            distance = fabs(newVehicle->x - activeVehicles[i].x);
-                            break;
-                    }
+                    const ApproachGeometry *approach = &APPROACHES[newVehicle->direction];
+                    float distance = fabs((newVehicle->x - activeVehicles[i].x) * approach->headingX +
+                                          (newVehicle->y - activeVehicles[i].y) * approach->headingY);
                     
                     if (distance < MIN_SPACING) {
                         canSpawn = false;
@@ -87,29 +83,24 @@ int main(int argc, char *argv[]) {
             if (canSpawn) {
                 vehicleCounter++;
                 printf("Generated Vehicle #%d - Direction: %d, Color: %d\n",
-                       vehicleCounter, newVehicle->direction, newVehicle->colorIndex);
+                       vehicleCounter, newVehicle->direction, newVehicle->profile);
 
                 
-                if (activeCount < MAX_CONCURRENT_VEHICLES) {
-                    activeVehicles[activeCount] = *newVehicle;
-                    activeCount++;
-                } else {
-                   
-                    for (int i = 0; i < activeCount - 1; i++) {
-                        activeVehicles[i] = activeVehicles[i + 1];
-                    }
-                    activeVehicles[activeCount - 1] = *newVehicle;
+                if (activeVehicles.full()) {
+                    Vehicle oldest;
+                    activeVehicles.pop(oldest);
                 }
+                activeVehicles.push(*newVehicle);
 
                 
                 fseek(file, 0, SEEK_SET);
-                for (int i = 0; i < activeCount; i++) {
+                for (unsigned i = 0; i < activeVehicles.size(); i++) {
                     writeVehicleToFile(file, &activeVehicles[i]);
                 }
                 fflush(file);
             }
 
-            free(newVehicle);
+            freeVehicle(newVehicle);
         }
 
         
@@ -1,8 +1,16 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <math.h>
 #include "traffic_simulation.h"
+#include "arrival_queue.h"
+#include "worker_pool.h"
+#include "motion.h"
+#include "event_simulation.h"
+#include "network.h"
+#include "partition.h"
+#include "road_network.h"
 
 void initializeSDL(SDL_Window **window, SDL_Renderer **renderer) {
     SDL_Init(SDL_INIT_VIDEO);
@@ -28,109 +36,389 @@ void handleEvents(bool *running) {
     }
 }
 
+typedef struct {
+    bool headless;
+    bool events;    // Discrete-event engine instead of fixed steps (implies headless)
+    float seconds;  // Simulated seconds to run headless
+    float warp;     // Simulated seconds per wall second in the window
+    Uint64 seed;    // Same seed, same run
+    int threads;    // Threads updating lanes, including the main one
+    int rows;       // Junction grid; the window shows the top-left junction
+    int columns;
+    const char* map;  // Road network file to load and report on, or NULL
+    bool routes;      // Vehicles get destinations and follow next-hop tables
+} Options;
+
+static void parseOptions(int argc, char *argv[], Options *options) {
+    options->headless = false;
+    options->events = false;
+    options->seconds = 3600.0f;
+    options->warp = 1.0f;
+    options->seed = (Uint64)time(NULL);
+    options->threads = SDL_GetCPUCount();
+    options->rows = 1;
+    options->columns = 1;
+    options->map = NULL;
+    options->routes = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            options->headless = true;
+        } else if (strcmp(argv[i], "--events") == 0) {
+            options->events = true;
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            options->seconds = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--warp") == 0 && i + 1 < argc) {
+            options->warp = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options->seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options->threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--grid") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &options->rows, &options->columns) != 2) {
+                printf("Expected --grid ROWSxCOLUMNS, got %s\n", argv[i]);
+                options->rows = options->columns = 1;
+            }
+        } else if (strcmp(argv[i], "--routes") == 0) {
+            options->routes = true;
+        } else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+            options->map = argv[++i];
+        } else {
+            printf("Unknown option %s (usage: %s [--headless | --events] [--seconds N] [--warp 1-1000] [--seed N] [--threads N] [--grid RxC] [--routes] [--map FILE])\n",
+                   argv[i], argv[0]);
+        }
+    }
+}
+
+// Lane update of a lone junction split into chunks of LANE_CHUNK_VEHICLES for the worker
+// pool; chunks of lane l are [chunkStart[l], chunkStart[l + 1]). A network of several
+// junctions is split between threads by junction instead (see partition.h).
+typedef struct {
+    Intersection* junction;
+    int chunkStart[5];
+    SDL_atomic_t exited[4];  // Vehicles each lane lost at its tile edge this step
+} LaneUpdateJob;
+
+static void updateLaneChunk(void *context, int index) {
+    LaneUpdateJob *job = (LaneUpdateJob *)context;
+
+    // Last lane starting at or before this chunk (empty lanes start where the next one does)
+    int lane = 3;
+    while (job->chunkStart[lane] > index) {
+        lane--;
+    }
+
+    Queue *q = &job->junction->lanes[lane];
+    int begin = (index - job->chunkStart[lane]) * LANE_CHUNK_VEHICLES;
+    int end = begin + LANE_CHUNK_VEHICLES < q->size ? begin + LANE_CHUNK_VEHICLES : q->size;
+    int exited = updateLaneRange(job->junction, (Direction)lane, begin, end);
+    if (exited > 0) {
+        SDL_AtomicAdd(&job->exited[lane], exited);
+    }
+}
+
+// Every vehicle moves against the previous tick's snapshot and the conflict grid, so the
+// result is the same for any thread count. runParallel returns only once all lanes are done.
+static void updateLanes(WorkerPool *workers, LaneUpdateJob *job) {
+    Intersection *junction = job->junction;
+    job->chunkStart[0] = 0;
+
+    int vehicles = 0;
+    for (int lane = 0; lane < 4; lane++) {
+        Queue *q = &junction->lanes[lane];
+        snapshotLane(q, (Direction)lane);
+        job->chunkStart[lane + 1] = job->chunkStart[lane] + (q->size + LANE_CHUNK_VEHICLES - 1) / LANE_CHUNK_VEHICLES;
+        SDL_AtomicSet(&job->exited[lane], 0);
+        vehicles += q->size;
+    }
+    buildConflictGrid(&junction->conflicts, junction->lanes);
+
+    if (vehicles >= LANE_PARALLEL_MIN_VEHICLES) {
+        runParallel(workers, updateLaneChunk, job, job->chunkStart[4]);
+    } else {
+        for (int i = 0; i < job->chunkStart[4]; i++) {
+            updateLaneChunk(job, i);
+        }
+    }
+
+    for (int lane = 0; lane < 4; lane++) {
+        wakeFollowers(&junction->lanes[lane]);
+        junction->laneExits[lane] = SDL_AtomicGet(&job->exited[lane]);
+    }
+    restoreLaneOrder(junction);
+}
+
+// One simulation step: admit due arrivals, update lanes and lights, advance time
+static void stepSimulation(Network *network, Statistics *stats, ArrivalGenerator *arrivals,
+                           WorkerPool *workers, LaneUpdateJob *job, DomainDecomposition *domains) {
+    Uint32 currentTime = getSimulationTime();
+
+    // Move every arrival due by now into its lane at the edge of the network
+    waitForArrivals(arrivals, currentTime);
+    for (int lane = 0; lane < 4; lane++) {
+        Vehicle arrival;
+        while (takeArrival(arrivals, lane, currentTime, &arrival)) {
+            admitArrival(network, (Direction)lane, &arrival);
+            const char* turnNames[] = {"STRAIGHT", "LEFT", "RIGHT"};
+            SIM_LOG("=== SPAWNED: Dir=%s, Turn=%s, Color=%d ===\n", 
+                    APPROACHES[lane].name,
+                    turnNames[arrival.turnDirection],
+                    arrival.profile);
+            
+            stats->totalVehicles++;
+        }
+        stats->laneDropped[lane] = SDL_AtomicGet(&arrivals->lanes[lane].dropped);
+        stats->laneRetries[lane] = SDL_AtomicGet(&arrivals->lanes[lane].retries);
+    }
+
+    // Turned vehicles change lanes, vehicles leaving a tile move on to the next junction,
+    // then exited ones are dropped in one batch before the signal decision
+    int left;
+    if (network->count > 1) {
+        left = stepDomains(domains, workers);
+    } else {
+        updateLanes(workers, job);
+        left = handOffJunctionExits(job->junction);
+        finishJunction(job->junction);
+    }
+    if (left > 0) {
+        SIM_LOG("%d vehicle(s) left the network\n", left);
+        stats->vehiclesPassed += left;
+    }
+    refreshNetworkRoutes(network, workers);
+
+    tickSimulationClock(&simulationClock);
+    float minutes = (getSimulationTime() - stats->startTime) / 60000.0f;
+    if (minutes > 0) {
+        stats->vehiclesPerMinute = stats->vehiclesPassed / minutes;
+    }
+}
+
+static void printStatus(Network *network, Statistics *stats, bool warmedUp, unsigned long warmupAllocations) {
+    // Summed over every junction
+    int sizes[4] = {0, 0, 0, 0};
+    for (int j = 0; j < network->count; j++) {
+        for (int lane = 0; lane < 4; lane++) {
+            sizes[lane] += network->junctions[j].lanes[lane].size;
+        }
+    }
+    printf("\n[STATUS] Queue sizes: N=%d, S=%d, E=%d, W=%d | Total passed: %d\n",
+           sizes[0], sizes[1], sizes[2], sizes[3],
+           stats->vehiclesPassed);
+    printf("[ARRIVALS] Dropped: N=%d, S=%d, E=%d, W=%d | Retries: N=%d, S=%d, E=%d, W=%d\n",
+           stats->laneDropped[0], stats->laneDropped[1],
+           stats->laneDropped[2], stats->laneDropped[3],
+           stats->laneRetries[0], stats->laneRetries[1],
+           stats->laneRetries[2], stats->laneRetries[3]);
+    if (warmedUp) {
+        printf("[MEMORY] Heap allocations since warm-up: %lu\n",
+               heapAllocationCount() - warmupAllocations);
+    }
+}
+
+// Loads a road network file and reports its size and load time
+static int runMapCheck(const char *path) {
+    RoadNetwork roads;
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (!loadRoadNetwork(&roads, path)) {
+        return 1;
+    }
+    double loadMs = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+    int signalised = 0;
+    for (int n = 0; n < roads.nodeCount; n++) {
+        if (roads.signalGroups[n] > 0) signalised++;
+    }
+    printf("[MAP] %s: %d nodes (%d signalised), %d links, %d lanes\n",
+           path, roads.nodeCount, signalised, roads.linkCount, roads.laneCount);
+    printf("[MAP] Loaded in %.1f ms, %.1f MB\n", loadMs, roadNetworkBytes(&roads) / (1024.0 * 1024.0));
+    freeRoadNetwork(&roads);
+    return 0;
+}
+
+// Long-horizon run on the discrete-event engine: aggregate statistics only
+static void runEvents(float seconds, Uint32 spawnInterval) {
+    printf("Traffic Simulation Started - DISCRETE EVENTS, %.0f simulated seconds\n", seconds);
+
+    EventStatistics stats;
+    Uint64 wallStart = SDL_GetPerformanceCounter();
+    runEventSimulation((Uint32)(seconds * 1000.0f), spawnInterval, &stats);
+    double wallSeconds = (double)(SDL_GetPerformanceCounter() - wallStart) / SDL_GetPerformanceFrequency();
+
+    printf("[EVENTS] Simulated %.1f s in %.3f s wall time (%lu events): %.1f simulated seconds per wall second\n",
+           seconds, wallSeconds, stats.eventsProcessed, wallSeconds > 0 ? seconds / wallSeconds : 0.0);
+    printf("[EVENTS] Vehicles spawned: %d | passed: %d | per minute: %.1f\n",
+           stats.totalVehicles, stats.vehiclesPassed, stats.vehiclesPerMinute);
+    printf("[EVENTS] Stopped at the line: %d | mean wait: %.2f s | longest line: N=%d, S=%d, E=%d, W=%d\n",
+           stats.vehiclesStopped,
+           stats.vehiclesStopped > 0 ? stats.totalWaitMs / stats.vehiclesStopped / 1000.0 : 0.0,
+           stats.longestLine[0], stats.longestLine[1], stats.longestLine[2], stats.longestLine[3]);
+}
+
 int main(int argc, char *argv[]) {
     SDL_Window *window = NULL;
     SDL_Renderer *renderer = NULL;
     bool running = true;
-    Uint32 lastVehicleSpawn = 0;
+    static ArrivalGenerator arrivals;
+    WorkerPool workers;
+    Network network;
+    LaneUpdateJob job;
+    static DomainDecomposition domains;
     const Uint32 SPAWN_INTERVAL = 2000;
+    const Uint32 WARMUP_TIME = 30000;
+    bool warmedUp = false;
+    unsigned long warmupAllocations = 0;
+    Options options;
 
-    srand(time(NULL));
-    initializeSDL(&window, &renderer);
-    TrafficLight lights[4];
-    initializeTrafficLights(lights);
+    parseOptions(argc, argv, &options);
+    initSimulationClock(&simulationClock, SIM_STEP_MS, options.warp);
+    seedSimulationRandom(&simulationRandom, options.seed);
+    printf("Seed: %llu\n", (unsigned long long)options.seed);
+    if (options.map) {
+        SDL_Init(SDL_INIT_TIMER);
+        int status = runMapCheck(options.map);
+        SDL_Quit();
+        return status;
+    }
+    if (options.events) {
+        SDL_Init(SDL_INIT_TIMER);
+        runEvents(options.seconds, SPAWN_INTERVAL);
+        SDL_Quit();
+        return 0;
+    }
+    selectMotionKernel();
+    printf("Motion kernel: %s\n", motionKernelName());
+    if (options.headless) {
+        // No video subsystem: batch servers have no display
+        SDL_Init(SDL_INIT_TIMER);
+        simulationVerbose = false;
+    } else {
+        initializeSDL(&window, &renderer);
+    }
     Statistics stats = {
         .vehiclesPassed = 0,
         .totalVehicles = 0,
         .vehiclesPerMinute = 0,
-        .startTime = SDL_GetTicks()
+        .startTime = getSimulationTime(),
+        .laneDropped = {0},
+        .laneRetries = {0}
     };
-    for (int i = 0; i < 4; i++) {
-        initQueue(&laneQueues[i]);
+    if (!initNetwork(&network, options.rows, options.columns)) {
+        cleanupSDL(window, renderer);
+        return 1;
+    }
+    printf("Junctions: %dx%d\n", network.rows, network.columns);
+    job.junction = &network.junctions[0];
+    if (!startWorkerPool(&workers, options.threads)) {
+        cleanupSDL(window, renderer);
+        return 1;
+    }
+    // One partition per thread, the calling thread included
+    initDomainDecomposition(&domains, &network, workers.threadCount + 1);
+    if (options.routes) {
+        Uint64 routeStart = SDL_GetPerformanceCounter();
+        if (!initNetworkRoutes(&network, &workers)) {
+            stopWorkerPool(&workers);
+            freeDomainDecomposition(&domains);
+            cleanupSDL(window, renderer);
+            return 1;
+        }
+        printf("Routes: %d destinations, tables built in %.1f ms\n", network.routes->cache.destinationCount,
+               (double)(SDL_GetPerformanceCounter() - routeStart) * 1000.0 / SDL_GetPerformanceFrequency());
+    }
+    // Each entry into the network sees as much traffic as one approach of a lone junction.
+    // Kept fractional: on large grids the interval drops below a millisecond.
+    if (!startArrivalGenerator(&arrivals, SPAWN_INTERVAL * 4.0 / boundaryEntryCount(&network))) {
+        stopWorkerPool(&workers);
+        freeDomainDecomposition(&domains);
+        cleanupSDL(window, renderer);
+        return 1;
     }
 
-    printf("Traffic Simulation Started - Queue Based with LEFT TURNS\n");
-    printf("GREEN BACKGROUND | 4 Queues: North, South, East, West\n");
-    printf("15%% vehicles will turn LEFT, 85%% go STRAIGHT\n\n");
+    if (options.headless) {
+        printf("Traffic Simulation Started - HEADLESS, %.0f simulated seconds\n", options.seconds);
 
-    while (running) {
-        handleEvents(&running);
+        Uint32 endTime = (Uint32)(options.seconds * 1000.0f);
+        Uint64 wallStart = SDL_GetPerformanceCounter();
 
-        Uint32 currentTime = SDL_GetTicks();
-        if (currentTime - lastVehicleSpawn >= SPAWN_INTERVAL) {
-            Direction spawnDirection = (Direction)(rand() % 4);
-            Vehicle *newVehicle = createVehicle(spawnDirection);
-            if (newVehicle) {
-                const char* dirNames[] = {"NORTH", "SOUTH", "EAST", "WEST"};
-                const char* turnNames[] = {"STRAIGHT", "LEFT", "RIGHT"};
-                printf("=== SPAWNED: Dir=%s, Turn=%s, Color=%d, Queue size=%d ===\n", 
-                       dirNames[spawnDirection], 
-                       turnNames[newVehicle->turnDirection],
-                       newVehicle->colorIndex,
-                       laneQueues[spawnDirection].size);
-                
-                stats.totalVehicles++;
-                free(newVehicle);
+        // Step as fast as the CPU allows, with the same warm-up mark as the windowed loop
+        while (getSimulationTime() < endTime) {
+            if (!warmedUp && getSimulationTime() - stats.startTime >= WARMUP_TIME) {
+                warmedUp = true;
+                warmupAllocations = heapAllocationCount();
             }
-            
-            lastVehicleSpawn = currentTime;
+            stepSimulation(&network, &stats, &arrivals, &workers, &job, &domains);
         }
-        
-        static Uint32 lastDebug = 0;
-        if (currentTime - lastDebug >= 3000) {
-            printf("\n[STATUS] Queue sizes: N=%d, S=%d, E=%d, W=%d | Total passed: %d\n",
-                   laneQueues[0].size, laneQueues[1].size, 
-                   laneQueues[2].size, laneQueues[3].size,
-                   stats.vehiclesPassed);
-            lastDebug = currentTime;
+
+        double wallSeconds = (double)(SDL_GetPerformanceCounter() - wallStart) / SDL_GetPerformanceFrequency();
+        double simSeconds = getSimulationTime() / 1000.0;
+        printStatus(&network, &stats, warmedUp, warmupAllocations);
+        printf("[HEADLESS] Simulated %.1f s in %.3f s wall time: %.1f simulated seconds per wall second\n",
+               simSeconds, wallSeconds, wallSeconds > 0 ? simSeconds / wallSeconds : 0.0);
+        printf("[HEADLESS] Vehicles spawned: %d | passed: %d | per minute: %.1f\n",
+               stats.totalVehicles, stats.vehiclesPassed, stats.vehiclesPerMinute);
+        if (network.routes) {
+            const RouteCache *cache = &network.routes->cache;
+            int refreshes = cache->repairs + cache->rebuilds;
+            printf("[ROUTES] %d update(s) after congestion changes (%d repaired, %d rebuilt), %.0f table entry "
+                   "update(s) each on average against %lu for a full rebuild\n", refreshes, cache->repairs,
+                   cache->rebuilds, refreshes > 0 ? (double)cache->entryUpdates / refreshes : 0.0,
+                   (unsigned long)cache->destinationCount * cache->roads->linkCount);
         }
-        for (int lane = 0; lane < 4; lane++) {
-            Node *current = laneQueues[lane].front;
-            Node *prev = NULL;
+        if (network.count > 1) {
+            printf("[PARTITIONS] %d partition(s), re-split %d time(s), %lu task(s) stolen\n",
+                   domains.count, domains.resplits, domains.scheduler.steals);
+        }
+        running = false;
+    } else {
+        printf("Traffic Simulation Started - Queue Based with LEFT TURNS (time warp %.0fx)\n",
+               simulationClock.warp);
+        printf("GREEN BACKGROUND | 4 Queues: North, South, East, West\n");
+        printf("15%% vehicles will turn LEFT, 85%% go STRAIGHT\n\n");
+    }
+
+    Uint32 lastDebug = 0;
+    Uint64 lastFrame = SDL_GetPerformanceCounter();
+    while (running) {
+        handleEvents(&running);
+
+        // Run however many fixed steps the warped wall clock says are due, then draw once
+        Uint64 now = SDL_GetPerformanceCounter();
+        double wallMs = (double)(now - lastFrame) * 1000.0 / SDL_GetPerformanceFrequency();
+        lastFrame = now;
+        int steps = accumulateWallTime(&simulationClock, wallMs);
+
+        for (int i = 0; i < steps; i++) {
+            Uint32 currentTime = getSimulationTime();
             
-            while (current != NULL) {
-                Vehicle *v = &current->vehicle;
-                
-                if (v->active) {
-                    
-                    updateVehicle(v, lights);
-                    
-                    if (!v->active) {
-                        printf("Vehicle removed from lane %d, Queue size now: %d\n", 
-                               lane, laneQueues[lane].size - 1);
-                        stats.vehiclesPassed++;
-                        Node *toDelete = current;
-                        if (prev == NULL) {
-                            laneQueues[lane].front = current->next;
-                        } else {
-                            prev->next = current->next;
-                        }
-                        
-                        if (current == laneQueues[lane].rear) {
-                            laneQueues[lane].rear = prev;
-                        }
-                        
-                        current = current->next;
-                        free(toDelete);
-                        laneQueues[lane].size--;
-                        continue;
-                    }
-                }
-                
-                prev = current;
-                current = current->next;
+            // Lanes, handoff links and conflict grids are sized when the network is built
+            // and only grow past that, so after warm-up nothing should allocate
+            if (!warmedUp && currentTime - stats.startTime >= WARMUP_TIME) {
+                warmedUp = true;
+                warmupAllocations = heapAllocationCount();
             }
+
+            if (currentTime - lastDebug >= 3000) {
+                printStatus(&network, &stats, warmedUp, warmupAllocations);
+                lastDebug = currentTime;
+            }
+
+            stepSimulation(&network, &stats, &arrivals, &workers, &job, &domains);
         }
-        updateTrafficLights(lights);
-        float minutes = (SDL_GetTicks() - stats.startTime) / 60000.0f;
-        if (minutes > 0) {
-            stats.vehiclesPerMinute = stats.vehiclesPassed / minutes;
-        }
-        renderSimulation(renderer, lights, &stats);
+        renderSimulation(renderer, &network.junctions[0]);
 
         SDL_Delay(16); 
     }
 
-    cleanupSDL(window, renderer);
+    stopArrivalGenerator(&arrivals);
+    stopWorkerPool(&workers);
+    freeDomainDecomposition(&domains);
+    freeNetwork(&network);
+
+    if (options.headless) {
+        SDL_Quit();
+    } else {
+        cleanupSDL(window, renderer);
+    }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,122 @@
+#include "motion.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MOTION_HAS_AVX2_KERNEL 1
+#endif
+
+// Both kernels do the same float operations in the same order, so they agree bit for bit.
+// Multiplying by an exact 0/1 mask (or ANDing with an all-ones mask) replaces the branches.
+static int advanceScalar(float *x, float *y, float *speed, const float *dx, const float *dy,
+                         Uint8 *flags, int count) {
+    int exited = 0;
+
+    for (int i = 0; i < count; i++) {
+        Uint8 f = flags[i];
+        float accelerating = (float)((f & (VEHICLE_ACTIVE | VEHICLE_STOPPED)) == VEHICLE_ACTIVE);
+        float straight = (float)((f & (VEHICLE_ACTIVE | VEHICLE_TURNING)) == VEHICLE_ACTIVE);
+
+        float s = speed[i] + VEHICLE_ACCELERATION * accelerating;
+        s = s < VEHICLE_MAX_SPEED ? s : VEHICLE_MAX_SPEED;
+        speed[i] = s;
+
+        float step = s * straight;
+        float px = x[i] + dx[i] * step;
+        float py = y[i] + dy[i] * step;
+        x[i] = px;
+        y[i] = py;
+
+        int inside = (px >= -VEHICLE_CULL_MARGIN) & (px <= WINDOW_WIDTH + VEHICLE_CULL_MARGIN) &
+                     (py >= -VEHICLE_CULL_MARGIN) & (py <= WINDOW_HEIGHT + VEHICLE_CULL_MARGIN);
+        int culled = (f & VEHICLE_ACTIVE) & !inside;
+        flags[i] = f & ~(culled * VEHICLE_ACTIVE);
+        exited += culled;
+    }
+
+    return exited;
+}
+
+#ifdef MOTION_HAS_AVX2_KERNEL
+// Eight vehicles per iteration; the tail goes through the scalar kernel
+__attribute__((target("avx2")))
+static int advanceAvx2(float *x, float *y, float *speed, const float *dx, const float *dy,
+                       Uint8 *flags, int count) {
+    const __m256 acceleration = _mm256_set1_ps(VEHICLE_ACCELERATION);
+    const __m256 maxSpeed = _mm256_set1_ps(VEHICLE_MAX_SPEED);
+    const __m256 minBound = _mm256_set1_ps(-VEHICLE_CULL_MARGIN);
+    const __m256 maxX = _mm256_set1_ps(WINDOW_WIDTH + VEHICLE_CULL_MARGIN);
+    const __m256 maxY = _mm256_set1_ps(WINDOW_HEIGHT + VEHICLE_CULL_MARGIN);
+    const __m256i active = _mm256_set1_epi32(VEHICLE_ACTIVE);
+    const __m256i activeStopped = _mm256_set1_epi32(VEHICLE_ACTIVE | VEHICLE_STOPPED);
+    const __m256i activeTurning = _mm256_set1_epi32(VEHICLE_ACTIVE | VEHICLE_TURNING);
+
+    int exited = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i f = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(flags + i)));
+        __m256 accelerating = _mm256_castsi256_ps(
+            _mm256_cmpeq_epi32(_mm256_and_si256(f, activeStopped), active));
+        __m256 straight = _mm256_castsi256_ps(
+            _mm256_cmpeq_epi32(_mm256_and_si256(f, activeTurning), active));
+        __m256 isActive = _mm256_castsi256_ps(
+            _mm256_cmpeq_epi32(_mm256_and_si256(f, active), active));
+
+        __m256 s = _mm256_add_ps(_mm256_loadu_ps(speed + i), _mm256_and_ps(acceleration, accelerating));
+        s = _mm256_min_ps(s, maxSpeed);
+        _mm256_storeu_ps(speed + i, s);
+
+        __m256 step = _mm256_and_ps(s, straight);
+        __m256 px = _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(_mm256_loadu_ps(dx + i), step));
+        __m256 py = _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(_mm256_loadu_ps(dy + i), step));
+        _mm256_storeu_ps(x + i, px);
+        _mm256_storeu_ps(y + i, py);
+
+        __m256 inside = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(px, minBound, _CMP_GE_OQ), _mm256_cmp_ps(px, maxX, _CMP_LE_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(py, minBound, _CMP_GE_OQ), _mm256_cmp_ps(py, maxY, _CMP_LE_OQ)));
+        int culled = _mm256_movemask_ps(_mm256_andnot_ps(inside, isActive));
+
+        exited += __builtin_popcount(culled);
+        for (int k = 0; k < 8; k++) {
+            flags[i + k] &= ~(((culled >> k) & 1) * VEHICLE_ACTIVE);
+        }
+    }
+
+    return exited + advanceScalar(x + i, y + i, speed + i, dx + i, dy + i, flags + i, count - i);
+}
+#endif
+
+static MotionKernel motionKernel = advanceScalar;
+
+// Picks the widest kernel this CPU supports (CPUID through SDL). Call once before any lane update.
+void selectMotionKernel(void) {
+    motionKernel = advanceScalar;
+#ifdef MOTION_HAS_AVX2_KERNEL
+    if (SDL_HasAVX2()) {
+        motionKernel = advanceAvx2;
+    }
+#endif
+}
+
+const char *motionKernelName(void) {
+#ifdef MOTION_HAS_AVX2_KERNEL
+    if (motionKernel == advanceAvx2) return "AVX2";
+#endif
+    return "scalar";
+}
+
+// Vehicles [begin, end) from the front: the ring wraps at most once, so at most two runs
+int advanceLaneRange(Queue *q, int begin, int end) {
+    if (begin >= end) return 0;
+
+    int first = QUEUE_SLOT(q, begin);
+    int count = end - begin;
+    int run = q->capacity - first < count ? q->capacity - first : count;
+
+    int exited = motionKernel(q->x + first, q->y + first, q->speed + first,
+                              q->dx + first, q->dy + first, q->flags + first, run);
+    if (run < count) {
+        exited += motionKernel(q->x, q->y, q->speed, q->dx, q->dy, q->flags, count - run);
+    }
+    return exited;
+}
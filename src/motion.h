@@ -0,0 +1,23 @@
+#ifndef MOTION_H
+#define MOTION_H
+
+#include "traffic_simulation.h"
+
+// Straight-line motion constants, per fixed step
+#define VEHICLE_MAX_SPEED 2.0f
+#define VEHICLE_ACCELERATION 0.1f
+#define VEHICLE_RESTART_SPEED 0.5f
+#define VEHICLE_CULL_MARGIN 50.0f  // How far off screen a vehicle may go before it leaves its lane
+
+// Advances count consecutive slots: accelerates every active, unstopped vehicle up to
+// VEHICLE_MAX_SPEED, moves the ones not turning along (dx, dy), and clears VEHICLE_ACTIVE
+// on any that left the screen. Returns how many left. No per-vehicle branches.
+typedef int (*MotionKernel)(float* x, float* y, float* speed, const float* dx, const float* dy,
+                            Uint8* flags, int count);
+
+// Motion kernel functions
+void selectMotionKernel(void);
+const char* motionKernelName(void);
+int advanceLaneRange(Queue* q, int begin, int end);
+
+#endif
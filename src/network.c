@@ -0,0 +1,360 @@
+#include <stdio.h>
+#include <string.h>
+#include "network.h"
+
+static void growHandoffLink(HandoffLink *link, int capacity) {
+    Vehicle *grown = (Vehicle *)simAlloc(sizeof(Vehicle) * capacity);
+    VehicleRoute *grownRoutes = (VehicleRoute *)simAlloc(sizeof(VehicleRoute) * capacity);
+    if (link->count > 0) {
+        memcpy(grown, link->items, sizeof(Vehicle) * link->count);
+        memcpy(grownRoutes, link->routes, sizeof(VehicleRoute) * link->count);
+    }
+    simFree(link->items);
+    simFree(link->routes);
+    link->items = grown;
+    link->routes = grownRoutes;
+    link->capacity = capacity;
+}
+
+static void freeHandoffLink(HandoffLink *link) {
+    if (link) {
+        simFree(link->items);
+        simFree(link->routes);
+        simFree(link);
+    }
+}
+
+bool initNetwork(Network *network, int rows, int columns) {
+    if (rows < 1 || columns < 1) {
+        printf("A network needs at least one row and one column of junctions\n");
+        return false;
+    }
+
+    network->rows = rows;
+    network->columns = columns;
+    network->count = rows * columns;
+    network->junctions = (Intersection *)simAlloc(sizeof(Intersection) * network->count);
+    memset(network->junctions, 0, sizeof(Intersection) * network->count);
+    for (int i = 0; i < 4; i++) {
+        network->nextEntry[i] = 0;
+    }
+    network->routes = NULL;
+
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            Intersection *junction = &network->junctions[row * columns + column];
+            junction->row = row;
+            junction->column = column;
+            for (int lane = 0; lane < 4; lane++) {
+                initQueue(&junction->lanes[lane]);
+                reserveQueue(&junction->lanes[lane], JUNCTION_LANE_RESERVE);
+            }
+            reserveConflictGrid(&junction->conflicts, CONFLICT_INITIAL_OCCUPANTS, CONFLICT_INITIAL_ENTRIES);
+            initializeTrafficLights(junction);
+            seedRng(&junction->rng, simulationRandom.seed, RNG_STREAM_JUNCTION(row * columns + column));
+
+            // Screen y grows downwards, so heading north means the row above
+            junction->downstream[DIRECTION_NORTH] = row > 0 ? junction - columns : NULL;
+            junction->downstream[DIRECTION_SOUTH] = row < rows - 1 ? junction + columns : NULL;
+            junction->downstream[DIRECTION_EAST] = column < columns - 1 ? junction + 1 : NULL;
+            junction->downstream[DIRECTION_WEST] = column > 0 ? junction - 1 : NULL;
+            for (int heading = 0; heading < 4; heading++) {
+                if (junction->downstream[heading]) {
+                    HandoffLink *link = (HandoffLink *)simAlloc(sizeof(HandoffLink));
+                    link->items = NULL;
+                    link->routes = NULL;
+                    link->count = 0;
+                    link->capacity = 0;
+                    growHandoffLink(link, HANDOFF_INITIAL_CAPACITY);
+                    junction->outbound[heading] = link;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void freeNetwork(Network *network) {
+    for (int i = 0; i < network->count; i++) {
+        Intersection *junction = &network->junctions[i];
+        for (int lane = 0; lane < 4; lane++) {
+            freeQueue(&junction->lanes[lane]);
+        }
+        freePriorityQueue(&junction->approachPriority);
+        freeConflictGrid(&junction->conflicts);
+        for (int heading = 0; heading < 4; heading++) {
+            freeHandoffLink(junction->outbound[heading]);
+        }
+    }
+    if (network->routes) {
+        freeRouteCache(&network->routes->cache);
+        freeRoadNetwork(&network->routes->roads);
+        simFree(network->routes->queueAverage);
+        simFree(network->routes);
+        network->routes = NULL;
+    }
+    simFree(network->junctions);
+    network->junctions = NULL;
+    network->count = 0;
+}
+
+// Approaches that enter from outside: northbound along the bottom row, southbound along
+// the top, eastbound down the left column and westbound down the right
+static int boundaryJunctions(const Network *network, Direction lane) {
+    return APPROACHES[lane].axis == AXIS_NORTH_SOUTH ? network->columns : network->rows;
+}
+
+int boundaryEntryCount(const Network *network) {
+    return 2 * (network->rows + network->columns);
+}
+
+static Intersection *boundaryJunction(Network *network, Direction lane, int index) {
+    switch (lane) {
+        case DIRECTION_NORTH: return &network->junctions[(network->rows - 1) * network->columns + index];
+        case DIRECTION_SOUTH: return &network->junctions[index];
+        case DIRECTION_EAST: return &network->junctions[index * network->columns];
+        default: return &network->junctions[index * network->columns + network->columns - 1];
+    }
+}
+
+static void addRoad(RoadNetwork *roads, int link, int from, int to, Direction heading, bool signalled) {
+    roads->linkFrom[link] = from;
+    roads->linkTo[link] = to;
+    roads->linkLength[link] = APPROACHES[heading].axis == AXIS_NORTH_SOUTH ? WINDOW_HEIGHT : WINDOW_WIDTH;
+    roads->linkLanes[link] = 1;
+    roads->linkSignal[link] = signalled ? (Sint8)APPROACHES[heading].axis : ROAD_NO_SIGNAL;
+}
+
+static const Direction OPPOSITE[4] = {DIRECTION_SOUTH, DIRECTION_NORTH, DIRECTION_WEST, DIRECTION_EAST};
+
+// Builds the road graph of the grid and a next-hop table towards every boundary side.
+// Vehicles can only go straight or turn left at a junction, and routes respect that.
+bool initNetworkRoutes(Network *network, WorkerPool *workers) {
+    int sides = boundaryEntryCount(network);
+    NetworkRoutes *routes = (NetworkRoutes *)simAlloc(sizeof(NetworkRoutes));
+    RoadNetwork *roads = &routes->roads;
+    if (!initRoadNetwork(roads, network->count + sides, network->count * 4 + sides)) {
+        simFree(routes);
+        return false;
+    }
+
+    int *exits = (int *)simAlloc(sizeof(int) * sides);
+    int node = network->count;
+    int link = 0;
+    for (int j = 0; j < network->count; j++) {
+        Intersection *junction = &network->junctions[j];
+        roads->nodeX[j] = junction->column * WINDOW_WIDTH + INTERSECTION_X;
+        roads->nodeY[j] = junction->row * WINDOW_HEIGHT + INTERSECTION_Y;
+    }
+
+    for (int j = 0; j < network->count; j++) {
+        Intersection *junction = &network->junctions[j];
+        for (int heading = 0; heading < 4; heading++) {
+            Intersection *next = junction->downstream[heading];
+            if (next) {
+                addRoad(roads, link, j, (int)(next - network->junctions), (Direction)heading, true);
+                next->approachLink[heading] = link++;
+                continue;
+            }
+
+            // A boundary side: one node a tile further on, with an exit to it and an entry from it
+            roads->nodeX[node] = roads->nodeX[j] + APPROACHES[heading].headingX * WINDOW_WIDTH;
+            roads->nodeY[node] = roads->nodeY[j] + APPROACHES[heading].headingY * WINDOW_HEIGHT;
+            addRoad(roads, link, j, node, (Direction)heading, false);
+            exits[node - network->count] = link++;
+            addRoad(roads, link, node, j, OPPOSITE[heading], true);
+            junction->approachLink[OPPOSITE[heading]] = link++;
+            node++;
+        }
+    }
+
+    float *cost = (float *)simAlloc(sizeof(float) * roads->linkCount);
+    for (int l = 0; l < roads->linkCount; l++) {
+        cost[l] = roads->linkLength[l] / ROUTE_CRUISE_SPEED;
+    }
+
+    bool ready = indexRoadNetwork(roads) &&
+                 initRouteCache(&routes->cache, roads, exits, sides, cost,
+                                ROUTE_TURN(TURN_STRAIGHT) | ROUTE_TURN(TURN_LEFT), workers);
+    simFree(exits);
+    simFree(cost);
+    if (!ready) {
+        freeRoadNetwork(roads);
+        simFree(routes);
+        return false;
+    }
+
+    routes->queueAverage = (float *)simAlloc(sizeof(float) * roads->linkCount);
+    for (int l = 0; l < roads->linkCount; l++) {
+        routes->queueAverage[l] = 0.0f;
+    }
+    routes->lastRefresh = getSimulationTime();
+    network->routes = routes;
+    for (int j = 0; j < network->count; j++) {
+        network->junctions[j].routes = &routes->cache;
+    }
+    return true;
+}
+
+// Feeds queue lengths back into the link costs. Lengths are smoothed first: a queue
+// swings by a whole signal cycle's worth of vehicles, and left raw that would change
+// nearly every link on every refresh.
+void refreshNetworkRoutes(Network *network, WorkerPool *workers) {
+    NetworkRoutes *routes = network->routes;
+    Uint32 now = getSimulationTime();
+    if (!routes || now - routes->lastRefresh < ROUTE_REFRESH_MS) return;
+    routes->lastRefresh = now;
+
+    for (int j = 0; j < network->count; j++) {
+        Intersection *junction = &network->junctions[j];
+        for (int lane = 0; lane < 4; lane++) {
+            int link = junction->approachLink[lane];
+            float *average = &routes->queueAverage[link];
+            *average += ROUTE_QUEUE_SMOOTHING * (junction->lanes[lane].size - *average);
+            float cost = routes->roads.linkLength[link] / ROUTE_CRUISE_SPEED + *average * ROUTE_QUEUE_DELAY;
+            updateLinkCost(&routes->cache, link, cost);
+        }
+    }
+    recomputeRoutes(&routes->cache, workers);
+}
+
+// Turn a vehicle arriving along this approach takes towards its destination, O(1)
+static Uint8 routeTurn(const Intersection *junction, Direction lane, Uint16 destination) {
+    int link = junction->approachLink[lane];
+    int next = routeNextLink(junction->routes, link, destination);
+    return next < 0 ? (Uint8)TURN_STRAIGHT : (Uint8)linkTurn(junction->routes->roads, link, next);
+}
+
+// Arrivals for an approach take turns among the junctions it enters the network at.
+// With routes, each one also gets a destination it can reach from there.
+void admitArrival(Network *network, Direction lane, const Vehicle *vehicle) {
+    Intersection *junction = boundaryJunction(network, lane, network->nextEntry[lane]);
+    network->nextEntry[lane] = (network->nextEntry[lane] + 1) % boundaryJunctions(network, lane);
+
+    Vehicle arrival = *vehicle;
+    VehicleRoute route = NO_ROUTE;
+    if (junction->routes) {
+        const RouteCache *cache = junction->routes;
+        int link = junction->approachLink[lane];
+        int destination = rngBelow(&junction->rng, cache->destinationCount);
+        // Going straight on always reaches some side, so this ends
+        while (routeNextLink(cache, link, destination) < 0) {
+            destination = (destination + 1) % cache->destinationCount;
+        }
+        route.origin = (Uint16)(cache->roads->linkFrom[link] - network->count);
+        route.destination = (Uint16)destination;
+        arrival.turnDirection = routeTurn(junction, lane, route.destination);
+    }
+    enqueueRouted(&junction->lanes[lane], arrival, route);
+}
+
+// Snapshot and conflict grid: everything the lane updates of one junction read
+void prepareJunction(Intersection *junction) {
+    for (int lane = 0; lane < 4; lane++) {
+        snapshotLane(&junction->lanes[lane], (Direction)lane);
+    }
+    buildConflictGrid(&junction->conflicts, junction->lanes);
+}
+
+// Touches only this lane, so the lanes of a prepared junction can be updated concurrently
+void updateJunctionLane(Intersection *junction, Direction lane) {
+    Queue *q = &junction->lanes[lane];
+    junction->laneExits[lane] = updateLaneRange(junction, lane, 0, q->size);
+    wakeFollowers(q);
+}
+
+// Snapshot, conflict grid, lane updates and lane order for one junction. Touches
+// nothing outside it, so junctions can be updated in any order or concurrently.
+void updateJunction(Intersection *junction) {
+    prepareJunction(junction);
+    for (int lane = 0; lane < 4; lane++) {
+        updateJunctionLane(junction, (Direction)lane);
+    }
+    restoreLaneOrder(junction);
+}
+
+// Carries on from the matching edge of the next tile, with the turn its route takes
+// there or else a fresh random one
+static void prepareHandoff(Intersection *from, const Intersection *next, Vehicle *vehicle, VehicleRoute route) {
+    const ApproachGeometry *approach = &APPROACHES[vehicle->direction];
+    vehicle->x -= approach->headingX * WINDOW_WIDTH;
+    vehicle->y -= approach->headingY * WINDOW_HEIGHT;
+    vehicle->flags = VEHICLE_ACTIVE;
+    vehicle->turnProgress = 0.0f;
+    if (next->routes && route.destination != VEHICLE_NO_ROUTE) {
+        vehicle->turnDirection = routeTurn(next, (Direction)vehicle->direction, route.destination);
+    } else {
+        vehicle->turnDirection = rngBelow(&from->rng, 100) < LEFT_TURN_PERCENT ? TURN_LEFT : TURN_STRAIGHT;
+    }
+}
+
+static void pushHandoff(HandoffLink *link, const Vehicle *vehicle, VehicleRoute route) {
+    if (link->count == link->capacity) {
+        growHandoffLink(link, link->capacity * 2);
+    }
+    link->routes[link->count] = route;
+    link->items[link->count++] = *vehicle;
+}
+
+// Vehicles the motion kernel culled at a tile edge keep their handle until compaction.
+// Each one goes into the link towards the next junction, O(1) apiece, and joins the back
+// of its same-heading approach when that junction drains its links after the barrier.
+// Only lanes that reported exits are scanned, and only up to the last one.
+// Every lane is fed by a single upstream junction, so arrival order never depends on
+// which junctions are handled first. Returns how many left the network instead.
+int handOffJunctionExits(Intersection *junction) {
+    int left = 0;
+
+    for (int lane = 0; lane < 4; lane++) {
+        Queue *q = &junction->lanes[lane];
+        int pending = junction->laneExits[lane];
+
+        for (int i = 0; i < q->size && pending > 0; i++) {
+            int slot = QUEUE_SLOT(q, i);
+            Vehicle v;
+            if ((q->flags[slot] & VEHICLE_ACTIVE) || !queueGet(q, q->handles[slot], &v)) {
+                continue;
+            }
+            pending--;
+
+            HandoffLink *link = junction->outbound[v.direction];
+            if (!link) {
+                left++;
+                continue;
+            }
+
+            VehicleRoute route = {q->origin[slot], q->destination[slot]};
+            prepareHandoff(junction, junction->downstream[v.direction], &v, route);
+            pushHandoff(link, &v, route);
+        }
+    }
+
+    return left;
+}
+
+// Takes in what the neighbours handed over during the update. Handed-off vehicles are
+// the newest on their approach, so the back is their place.
+void drainHandoffs(Intersection *junction) {
+    for (int heading = 0; heading < 4; heading++) {
+        // Traffic with this heading comes from the neighbour on the opposite side
+        Intersection *from = junction->downstream[OPPOSITE[heading]];
+        HandoffLink *link = from ? from->outbound[heading] : NULL;
+        if (!link) continue;
+
+        for (int i = 0; i < link->count; i++) {
+            enqueueRouted(&junction->lanes[heading], link->items[i], link->routes[i]);
+        }
+        link->count = 0;
+    }
+}
+
+// End of step for one junction, once everything handed to it has arrived:
+// drop exited vehicles in one batch, then the signal decision
+void finishJunction(Intersection *junction) {
+    drainHandoffs(junction);
+    for (int lane = 0; lane < 4; lane++) {
+        compactQueue(&junction->lanes[lane]);
+    }
+    updateTrafficLights(junction);
+}
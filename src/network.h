@@ -0,0 +1,80 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include "traffic_simulation.h"
+#include "conflict_grid.h"
+#include "route_cache.h"
+
+// Route costs: free-flow travel time plus a delay per vehicle queued on the link,
+// refreshed from the lanes every ROUTE_REFRESH_MS
+#define ROUTE_CRUISE_SPEED 125.0f  // Pixels per simulated second: 2 pixels a step
+#define ROUTE_QUEUE_DELAY 1.0f     // Seconds per queued vehicle
+#define ROUTE_REFRESH_MS 5000
+#define ROUTE_QUEUE_SMOOTHING 0.25f  // Weight of the latest queue length in the running average
+
+// Storage set aside per junction when the network is built, so a run that stays within
+// it never allocates once it's going
+#define JUNCTION_LANE_RESERVE QUEUE_INITIAL_CAPACITY  // Vehicles per approach
+#define HANDOFF_INITIAL_CAPACITY 8   // Vehicles crossing one tile edge in a step
+
+// Vehicles crossing from a junction to the next one along a heading. Written only once
+// the upstream junction's update is done and drained by the downstream one after the
+// tick barrier, so it needs no atomics, and it grows rather than refuse a vehicle.
+typedef struct {
+    Vehicle* items;
+    VehicleRoute* routes;  // Beside items, so Vehicle stays half a cache line
+    int count;
+    int capacity;
+} HandoffLink;
+
+// One signalised junction. Every junction uses the same tile-local geometry
+// (APPROACHES, INTERSECTION_X/Y); the one at (row, column) sits that many windows
+// right and down from the first.
+struct Intersection {
+    Queue lanes[4];                  // Approach queues, indexed by Direction
+    TrafficLight lights[4];
+    PriorityQueue approachPriority;  // Approaches ranked by congestion at each phase boundary
+    ConflictGrid conflicts;
+    Intersection* downstream[4];     // Next junction for each exit heading, NULL at the edge
+    HandoffLink* outbound[4];        // Towards each downstream junction, NULL at the edge
+    Rng rng;                         // Turn intentions of vehicles it hands on
+    int laneExits[4];                // Vehicles each lane lost at the tile edge this step
+    const RouteCache* routes;        // Set when vehicles follow routes
+    int approachLink[4];             // Road graph link each approach arrives along
+    int row, column;
+};
+
+// Routing over a grid network. The road graph has a node per junction and one per
+// boundary side, and a link per approach and per exit; boundary side b is both
+// origin b and destination b.
+typedef struct {
+    RoadNetwork roads;
+    RouteCache cache;
+    float* queueAverage;  // Per link: smoothed queue length its cost comes from
+    Uint32 lastRefresh;
+} NetworkRoutes;
+
+// Rows x columns grid of junctions joined by straight roads
+typedef struct {
+    Intersection* junctions;  // Row-major
+    int rows, columns;
+    int count;
+    int nextEntry[4];         // Round-robin over the boundary junctions each approach enters at
+    NetworkRoutes* routes;    // NULL unless vehicles follow routes
+} Network;
+
+// Network functions
+bool initNetwork(Network* network, int rows, int columns);
+void freeNetwork(Network* network);
+int boundaryEntryCount(const Network* network);
+bool initNetworkRoutes(Network* network, WorkerPool* workers);
+void refreshNetworkRoutes(Network* network, WorkerPool* workers);
+void admitArrival(Network* network, Direction lane, const Vehicle* vehicle);
+void prepareJunction(Intersection* junction);
+void updateJunctionLane(Intersection* junction, Direction lane);
+void updateJunction(Intersection* junction);
+int handOffJunctionExits(Intersection* junction);
+void drainHandoffs(Intersection* junction);
+void finishJunction(Intersection* junction);
+
+#endif
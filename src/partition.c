@@ -0,0 +1,154 @@
+#include <string.h>
+#include "partition.h"
+
+// Where each partition would end if the junctions were cut into equal shares of the load
+static void splitByLoad(const DomainDecomposition *domains, int *ends) {
+    int junctions = domains->network->count;
+    const long *prefix = domains->prefixLoad;
+    int first = 0;
+
+    for (int p = 0; p < domains->count - 1; p++) {
+        // Cut where the running load is closest to its share, leaving at least
+        // one junction for every partition after this one
+        long target = prefix[junctions] * (p + 1) / domains->count;
+        int lastEnd = junctions - (domains->count - 1 - p);
+        int end = first + 1;
+        while (end < lastEnd && prefix[end + 1] - target <= target - prefix[end]) {
+            end++;
+        }
+        ends[p] = end;
+        first = end;
+    }
+    ends[domains->count - 1] = junctions;
+}
+
+static long heaviestLoad(const DomainDecomposition *domains, const int *ends) {
+    long heaviest = 0;
+    int first = 0;
+    for (int p = 0; p < domains->count; p++) {
+        long load = domains->prefixLoad[ends[p]] - domains->prefixLoad[first];
+        if (load > heaviest) heaviest = load;
+        first = ends[p];
+    }
+    return heaviest;
+}
+
+static void applySplit(DomainDecomposition *domains) {
+    int first = 0;
+    for (int p = 0; p < domains->count; p++) {
+        Partition *partition = &domains->partitions[p];
+        partition->first = first;
+        partition->end = domains->splitEnd[p];
+        for (int j = first; j < partition->end; j++) {
+            domains->owner[j] = p;
+        }
+        first = partition->end;
+    }
+}
+
+static void measureLoad(DomainDecomposition *domains) {
+    Network *network = domains->network;
+    domains->prefixLoad[0] = 0;
+    for (int j = 0; j < network->count; j++) {
+        long load = PARTITION_JUNCTION_LOAD;
+        for (int lane = 0; lane < 4; lane++) {
+            load += network->junctions[j].lanes[lane].size;
+        }
+        domains->prefixLoad[j + 1] = domains->prefixLoad[j] + load;
+    }
+}
+
+void initDomainDecomposition(DomainDecomposition *domains, Network *network, int partitions) {
+    domains->network = network;
+    initJunctionScheduler(&domains->scheduler, network);
+    domains->count = partitions < network->count ? partitions : network->count;
+    if (domains->count < 1) domains->count = 1;
+    domains->partitions = (Partition *)simAlloc(sizeof(Partition) * domains->count);
+    domains->owner = (int *)simAlloc(sizeof(int) * network->count);
+    domains->prefixLoad = (long *)simAlloc(sizeof(long) * (network->count + 1));
+    domains->splitEnd = (int *)simAlloc(sizeof(int) * domains->count);
+    domains->lastCheck = getSimulationTime();
+    domains->resplits = 0;
+
+    measureLoad(domains);
+    splitByLoad(domains, domains->splitEnd);
+    applySplit(domains);
+}
+
+void freeDomainDecomposition(DomainDecomposition *domains) {
+    freeJunctionScheduler(&domains->scheduler);
+    simFree(domains->partitions);
+    simFree(domains->owner);
+    simFree(domains->prefixLoad);
+    simFree(domains->splitEnd);
+    domains->partitions = NULL;
+    domains->owner = NULL;
+    domains->prefixLoad = NULL;
+    domains->splitEnd = NULL;
+}
+
+// Re-splits when the heaviest partition carries clearly more than its share and a new
+// cut would lighten it. Returns true if it did.
+bool rebalanceDomains(DomainDecomposition *domains) {
+    measureLoad(domains);
+
+    for (int p = 0; p < domains->count; p++) {
+        domains->splitEnd[p] = domains->partitions[p].end;
+    }
+    long heaviest = heaviestLoad(domains, domains->splitEnd);
+    long total = domains->prefixLoad[domains->network->count];
+    if (heaviest * domains->count <= total * PARTITION_IMBALANCE) {
+        return false;
+    }
+
+    // Junctions are indivisible, so an even split may be out of reach
+    splitByLoad(domains, domains->splitEnd);
+    if (heaviestLoad(domains, domains->splitEnd) >= heaviest) {
+        return false;
+    }
+
+    applySplit(domains);
+    domains->resplits++;
+    return true;
+}
+
+static void finishPartition(void *context, int index) {
+    DomainDecomposition *domains = (DomainDecomposition *)context;
+    Partition *partition = &domains->partitions[index];
+
+    for (int j = partition->first; j < partition->end; j++) {
+        finishJunction(&domains->network->junctions[j]);
+    }
+}
+
+// One step of the whole network; returns how many vehicles left it
+int stepDomains(DomainDecomposition *domains, WorkerPool *workers) {
+    Uint32 now = getSimulationTime();
+    if (now - domains->lastCheck >= PARTITION_CHECK_MS) {
+        rebalanceDomains(domains);
+        domains->lastCheck = now;
+    }
+
+    // Below this much work (as of the last balance check) waking the workers costs more than it saves
+    Network *network = domains->network;
+    if (domains->prefixLoad[network->count] < LANE_PARALLEL_MIN_VEHICLES) {
+        int left = 0;
+        for (int j = 0; j < network->count; j++) {
+            updateJunction(&network->junctions[j]);
+            left += handOffJunctionExits(&network->junctions[j]);
+        }
+        for (int j = 0; j < network->count; j++) {
+            finishJunction(&network->junctions[j]);
+        }
+        return left;
+    }
+
+    // Junction updates go wherever there are idle threads; draining and compaction
+    // stay with the partition that owns the junction
+    for (int p = 0; p < domains->count; p++) {
+        seedJunctionTasks(&domains->scheduler, p, domains->partitions[p].first, domains->partitions[p].end);
+    }
+    int left = runJunctionTasks(&domains->scheduler, workers, domains->count);
+    runParallel(workers, finishPartition, domains, domains->count);
+    return left;
+}
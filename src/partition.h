@@ -0,0 +1,44 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include "network.h"
+#include "worker_pool.h"
+#include "work_stealing.h"
+
+// Load balancing: fixed work per junction in vehicle updates, how often the balance is
+// checked, and how far the heaviest partition may exceed the mean before a re-split
+#define PARTITION_JUNCTION_LOAD 4
+#define PARTITION_CHECK_MS 1000
+#define PARTITION_IMBALANCE 1.1f
+
+// A contiguous row-major run of junctions, owned by one thread
+typedef struct {
+    int first, end;   // Junctions [first, end)
+} Partition;
+
+// Domain decomposition of a network. A step is two parallel phases split by the
+// worker pool's barrier: junctions are updated and hand their exits to their links,
+// each thread starting on its own partition and stealing from the others once done,
+// then every partition drains its junctions' inbound links and finishes them.
+// Junctions only exchange vehicles through those links, so results don't depend on
+// the partitioning, the thread count or which thread ran what. The scheduler's
+// deques are cache-line aligned, so keep this in static storage.
+typedef struct {
+    Network* network;
+    JunctionScheduler scheduler;
+    Partition* partitions;
+    int count;
+    int* owner;            // Partition of each junction
+    long* prefixLoad;      // Scratch: load of junctions [0, j)
+    int* splitEnd;         // Scratch: partition ends of a candidate split
+    Uint32 lastCheck;
+    int resplits;
+} DomainDecomposition;
+
+// Domain decomposition functions
+void initDomainDecomposition(DomainDecomposition* domains, Network* network, int partitions);
+void freeDomainDecomposition(DomainDecomposition* domains);
+bool rebalanceDomains(DomainDecomposition* domains);
+int stepDomains(DomainDecomposition* domains, WorkerPool* workers);
+
+#endif
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pool.h"
+
+#define POOL_ALIGNMENT 16
+#define POOL_ROUND_UP(n) (((n) + POOL_ALIGNMENT - 1) & ~(size_t)(POOL_ALIGNMENT - 1))
+
+static unsigned long heapAllocations = 0;
+
+void *simAlloc(size_t size) {
+    void *ptr = malloc(size);
+    if (!ptr) {
+        fprintf(stderr, "Out of memory allocating %lu bytes\n", (unsigned long)size);
+        exit(1);
+    }
+    // Lane and handoff buffers grow from worker threads too
+    __atomic_fetch_add(&heapAllocations, 1, __ATOMIC_RELAXED);
+    return ptr;
+}
+
+void simFree(void *ptr) {
+    free(ptr);
+}
+
+unsigned long heapAllocationCount(void) {
+    return __atomic_load_n(&heapAllocations, __ATOMIC_RELAXED);
+}
+
+void initPool(Pool *pool, size_t blockSize, int blocksPerSlab) {
+    if (blockSize < sizeof(PoolBlock)) {
+        blockSize = sizeof(PoolBlock);
+    }
+    pool->blockSize = POOL_ROUND_UP(blockSize);
+    pool->blocksPerSlab = blocksPerSlab > 0 ? blocksPerSlab : POOL_SLAB_BLOCKS;
+    pool->slabs = NULL;
+    pool->freeList = NULL;
+    pool->slabCount = 0;
+    pool->blocksInUse = 0;
+}
+
+static void addSlab(Pool *pool) {
+    size_t header = POOL_ROUND_UP(sizeof(PoolSlab));
+    PoolSlab *slab = (PoolSlab *)simAlloc(header + pool->blockSize * pool->blocksPerSlab);
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->slabCount++;
+
+    // Thread the new blocks onto the free list, lowest address first
+    char *blocks = (char *)slab + header;
+    for (int i = pool->blocksPerSlab - 1; i >= 0; i--) {
+        PoolBlock *block = (PoolBlock *)(blocks + pool->blockSize * i);
+        block->next = pool->freeList;
+        pool->freeList = block;
+    }
+}
+
+void *poolAlloc(Pool *pool) {
+    if (pool->freeList == NULL) {
+        addSlab(pool);
+    }
+
+    PoolBlock *block = pool->freeList;
+    pool->freeList = block->next;
+    pool->blocksInUse++;
+    return block;
+}
+
+void poolFree(Pool *pool, void *block) {
+    if (block == NULL) return;
+
+    PoolBlock *entry = (PoolBlock *)block;
+    entry->next = pool->freeList;
+    pool->freeList = entry;
+    pool->blocksInUse--;
+}
+
+void destroyPool(Pool *pool) {
+    PoolSlab *slab = pool->slabs;
+    while (slab != NULL) {
+        PoolSlab *next = slab->next;
+        simFree(slab);
+        slab = next;
+    }
+    pool->slabs = NULL;
+    pool->freeList = NULL;
+    pool->slabCount = 0;
+    pool->blocksInUse = 0;
+}
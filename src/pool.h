@@ -0,0 +1,40 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+// Blocks carved out of each slab when the free list runs dry
+#define POOL_SLAB_BLOCKS 64
+
+// Free list entry, overlaid on an unused block
+typedef struct PoolBlock {
+    struct PoolBlock* next;
+} PoolBlock;
+
+// Slab header, followed in memory by its blocks
+typedef struct PoolSlab {
+    struct PoolSlab* next;
+} PoolSlab;
+
+// Fixed-block pool structure
+typedef struct {
+    size_t blockSize;
+    int blocksPerSlab;
+    PoolSlab* slabs;
+    PoolBlock* freeList;
+    int slabCount;
+    int blocksInUse;
+} Pool;
+
+// Pool functions
+void initPool(Pool* pool, size_t blockSize, int blocksPerSlab);
+void* poolAlloc(Pool* pool);
+void poolFree(Pool* pool, void* block);
+void destroyPool(Pool* pool);
+
+// Counted heap allocation, used by pools and queue growth
+void* simAlloc(size_t size);
+void simFree(void* ptr);
+unsigned long heapAllocationCount(void);
+
+#endif
@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include "priority_queue.h"
+#include "pool.h"
+
+static void swapSlots(PriorityQueue *pq, int a, int b) {
+    int idA = pq->heap[a];
+    int idB = pq->heap[b];
+    pq->heap[a] = idB;
+    pq->heap[b] = idA;
+    pq->position[idB] = a;
+    pq->position[idA] = b;
+}
+
+static void siftUp(PriorityQueue *pq, int slot) {
+    while (slot > 0) {
+        int parent = (slot - 1) / 2;
+        if (pq->priority[pq->heap[parent]] >= pq->priority[pq->heap[slot]]) break;
+        swapSlots(pq, slot, parent);
+        slot = parent;
+    }
+}
+
+static void siftDown(PriorityQueue *pq, int slot) {
+    for (;;) {
+        int left = slot * 2 + 1;
+        int right = left + 1;
+        int largest = slot;
+
+        if (left < pq->size && pq->priority[pq->heap[left]] > pq->priority[pq->heap[largest]]) {
+            largest = left;
+        }
+        if (right < pq->size && pq->priority[pq->heap[right]] > pq->priority[pq->heap[largest]]) {
+            largest = right;
+        }
+        if (largest == slot) break;
+
+        swapSlots(pq, slot, largest);
+        slot = largest;
+    }
+}
+
+void initPriorityQueue(PriorityQueue *pq, int capacity) {
+    pq->heap = (int *)simAlloc(sizeof(int) * capacity);
+    pq->position = (int *)simAlloc(sizeof(int) * capacity);
+    pq->priority = (float *)simAlloc(sizeof(float) * capacity);
+    pq->size = 0;
+    pq->capacity = capacity;
+
+    for (int i = 0; i < capacity; i++) {
+        pq->position[i] = -1;
+        pq->priority[i] = 0.0f;
+    }
+}
+
+void freePriorityQueue(PriorityQueue *pq) {
+    simFree(pq->heap);
+    simFree(pq->position);
+    simFree(pq->priority);
+    pq->heap = NULL;
+    pq->position = NULL;
+    pq->priority = NULL;
+    pq->size = 0;
+    pq->capacity = 0;
+}
+
+// Inserts the id or moves it to its new key, O(log n) either way
+void pqUpdate(PriorityQueue *pq, int id, float priority) {
+    if (pq->position[id] < 0) {
+        pq->heap[pq->size] = id;
+        pq->position[id] = pq->size;
+        pq->priority[id] = priority;
+        siftUp(pq, pq->size++);
+        return;
+    }
+
+    float old = pq->priority[id];
+    pq->priority[id] = priority;
+    if (priority > old) {
+        siftUp(pq, pq->position[id]);
+    } else if (priority < old) {
+        siftDown(pq, pq->position[id]);
+    }
+}
+
+void pqRemove(PriorityQueue *pq, int id) {
+    int slot = pq->position[id];
+    if (slot < 0) return;
+
+    int last = --pq->size;
+    if (slot != last) {
+        swapSlots(pq, slot, last);
+        siftDown(pq, slot);
+        siftUp(pq, slot);
+    }
+    pq->position[id] = -1;
+}
+
+int pqPeek(PriorityQueue *pq) {
+    return pq->size > 0 ? pq->heap[0] : -1;
+}
+
+int pqPop(PriorityQueue *pq) {
+    int top = pqPeek(pq);
+    if (top >= 0) {
+        pqRemove(pq, top);
+    }
+    return top;
+}
+
+bool pqContains(PriorityQueue *pq, int id) {
+    return pq->position[id] >= 0;
+}
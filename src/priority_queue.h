@@ -0,0 +1,24 @@
+#ifndef PRIORITY_QUEUE_H
+#define PRIORITY_QUEUE_H
+
+#include <stdbool.h>
+
+// Indexed binary max-heap over ids 0..capacity-1
+typedef struct {
+    int* heap;        // Heap slot -> id
+    int* position;    // id -> heap slot, -1 when not queued
+    float* priority;  // id -> current key
+    int size;
+    int capacity;
+} PriorityQueue;
+
+// Priority queue functions
+void initPriorityQueue(PriorityQueue* pq, int capacity);
+void freePriorityQueue(PriorityQueue* pq);
+void pqUpdate(PriorityQueue* pq, int id, float priority);
+void pqRemove(PriorityQueue* pq, int id);
+int pqPeek(PriorityQueue* pq);
+int pqPop(PriorityQueue* pq);
+bool pqContains(PriorityQueue* pq, int id);
+
+#endif
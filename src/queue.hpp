@@ -0,0 +1,342 @@
+#ifndef QUEUE_HPP
+#define QUEUE_HPP
+
+// Header-only ring queue shared by the simulator and the generator.
+// Everything is built with g++, so the C-style modules can include this directly.
+
+#include <type_traits>
+#include "pool.h"
+
+#define CACHE_LINE_SIZE 64
+
+namespace sim {
+
+// Growth policies
+struct FixedCapacity {};  // Inline array of Capacity elements, never touches the heap
+struct Growable {};       // Capacity is the starting size, doubles through simAlloc when full
+
+// Concurrency policies
+struct SingleThreaded {};
+struct Spsc {};           // One producer and one consumer thread, wait-free
+struct Mpmc {};           // Any number of producers and consumers, lock-free and bounded
+struct ChaseLev {};       // Work-stealing deque: the owner pushes and pops, any thread steals
+
+constexpr bool isPowerOfTwo(unsigned n) {
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+template <typename T, unsigned Capacity,
+          typename GrowthPolicy = FixedCapacity,
+          typename ConcurrencyPolicy = SingleThreaded>
+class Queue {
+    static_assert(sizeof(T) == 0, "lock-free queues are bounded: use FixedCapacity with Spsc or Mpmc");
+};
+
+// Single-threaded, fixed capacity: any capacity, storage sized at compile time
+template <typename T, unsigned Capacity>
+class Queue<T, Capacity, FixedCapacity, SingleThreaded> {
+    static_assert(Capacity > 0, "queue capacity must be positive");
+
+public:
+    Queue() { clear(); }
+
+    void clear() { head = 0; count = 0; }
+    unsigned size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == Capacity; }
+    static constexpr unsigned capacity() { return Capacity; }
+
+    bool push(const T& item) {
+        if (count == Capacity) return false;
+        items[(head + count) % Capacity] = item;
+        count++;
+        return true;
+    }
+
+    bool pop(T& item) {
+        if (count == 0) return false;
+        item = items[head];
+        head = (head + 1) % Capacity;
+        count--;
+        return true;
+    }
+
+    // index 0 is the front
+    T& operator[](unsigned index) { return items[(head + index) % Capacity]; }
+    const T& operator[](unsigned index) const { return items[(head + index) % Capacity]; }
+
+private:
+    T items[Capacity];
+    unsigned head;
+    unsigned count;
+};
+
+// Single-threaded, growable: power-of-two ring that doubles on demand
+template <typename T, unsigned Capacity>
+class Queue<T, Capacity, Growable, SingleThreaded> {
+    static_assert(isPowerOfTwo(Capacity), "initial capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "growable queue moves items with plain copies");
+
+public:
+    Queue() : items(nullptr), cap(0), head(0), count(0) {}
+    ~Queue() { simFree(items); }
+    Queue(const Queue&) = delete;
+    Queue& operator=(const Queue&) = delete;
+
+    void clear() { head = 0; count = 0; }
+    unsigned size() const { return count; }
+    bool empty() const { return count == 0; }
+    unsigned capacity() const { return cap; }
+
+    bool push(const T& item) {
+        if (count == cap) grow();
+        items[(head + count) & (cap - 1)] = item;
+        count++;
+        return true;
+    }
+
+    bool pop(T& item) {
+        if (count == 0) return false;
+        item = items[head];
+        head = (head + 1) & (cap - 1);
+        count--;
+        return true;
+    }
+
+    T& operator[](unsigned index) { return items[(head + index) & (cap - 1)]; }
+    const T& operator[](unsigned index) const { return items[(head + index) & (cap - 1)]; }
+
+private:
+    void grow() {
+        unsigned newCap = cap ? cap * 2 : Capacity;
+        T* grown = (T*)simAlloc(sizeof(T) * newCap);
+
+        // Unwrap so the front lands at index 0
+        for (unsigned i = 0; i < count; i++) {
+            grown[i] = (*this)[i];
+        }
+
+        simFree(items);
+        items = grown;
+        cap = newCap;
+        head = 0;
+    }
+
+    T* items;
+    unsigned cap;
+    unsigned head;
+    unsigned count;
+};
+
+// Single producer, single consumer: head and tail on their own cache lines,
+// each side caches the other's index and only re-reads it when it looks full/empty
+template <typename T, unsigned Capacity>
+class Queue<T, Capacity, FixedCapacity, Spsc> {
+    static_assert(isPowerOfTwo(Capacity), "SPSC capacity must be a power of two");
+
+public:
+    Queue() { clear(); }
+
+    // Not thread-safe: only call while neither side is running
+    void clear() { head = cachedTail = tail = cachedHead = 0; }
+    static constexpr unsigned capacity() { return Capacity; }
+
+    // Producer side
+    bool push(const T& item) {
+        unsigned t = tail;
+        if (t - cachedHead == Capacity) {
+            cachedHead = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+            if (t - cachedHead == Capacity) return false;
+        }
+
+        items[t & (Capacity - 1)] = item;
+        __atomic_store_n(&tail, t + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& item) {
+        unsigned h = head;
+        if (h == cachedTail) {
+            cachedTail = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+            if (h == cachedTail) return false;
+        }
+
+        item = items[h & (Capacity - 1)];
+        __atomic_store_n(&head, h + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // Approximate when called while the other side is running
+    unsigned size() const {
+        return __atomic_load_n(&tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    }
+
+private:
+    alignas(CACHE_LINE_SIZE) unsigned head;  // Written by the consumer only
+    unsigned cachedTail;
+    alignas(CACHE_LINE_SIZE) unsigned tail;  // Written by the producer only
+    unsigned cachedHead;
+    alignas(CACHE_LINE_SIZE) T items[Capacity];
+};
+
+// Multiple producers and consumers: Vyukov's bounded queue, one sequence number per cell.
+// push reports full instead of growing.
+template <typename T, unsigned Capacity>
+class Queue<T, Capacity, FixedCapacity, Mpmc> {
+    static_assert(isPowerOfTwo(Capacity), "MPMC capacity must be a power of two");
+
+public:
+    Queue() { clear(); }
+
+    // Not thread-safe: only call while no producer or consumer is running
+    void clear() {
+        for (unsigned i = 0; i < Capacity; i++) {
+            cells[i].sequence = i;
+        }
+        enqueuePos = 0;
+        dequeuePos = 0;
+    }
+    static constexpr unsigned capacity() { return Capacity; }
+
+    bool push(const T& item) {
+        unsigned pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+        Cell* cell;
+
+        for (;;) {
+            cell = &cells[pos & (Capacity - 1)];
+            unsigned sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+            int diff = (int)(sequence - pos);
+
+            if (diff == 0) {
+                // Cell is free for this lap, claim it
+                if (__atomic_compare_exchange_n(&enqueuePos, &pos, pos + 1, true,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+            }
+        }
+
+        cell->item = item;
+        __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    bool pop(T& item) {
+        unsigned pos = __atomic_load_n(&dequeuePos, __ATOMIC_RELAXED);
+        Cell* cell;
+
+        for (;;) {
+            cell = &cells[pos & (Capacity - 1)];
+            unsigned sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+            int diff = (int)(sequence - (pos + 1));
+
+            if (diff == 0) {
+                if (__atomic_compare_exchange_n(&dequeuePos, &pos, pos + 1, true,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = __atomic_load_n(&dequeuePos, __ATOMIC_RELAXED);
+            }
+        }
+
+        item = cell->item;
+        // Hand the cell back to producers for the next lap
+        __atomic_store_n(&cell->sequence, pos + Capacity, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    struct Cell {
+        unsigned sequence;
+        T item;
+    };
+
+    alignas(CACHE_LINE_SIZE) unsigned enqueuePos;
+    alignas(CACHE_LINE_SIZE) unsigned dequeuePos;
+    alignas(CACHE_LINE_SIZE) Cell cells[Capacity];
+};
+
+// Chase-Lev work-stealing deque, with the orderings of Le et al. for weak memory models.
+// The owner pushes and pops the newest item at the bottom without contention; thieves
+// take the oldest from the top and only race the owner for the last item. push reports
+// full instead of growing.
+template <typename T, unsigned Capacity>
+class Queue<T, Capacity, FixedCapacity, ChaseLev> {
+    static_assert(isPowerOfTwo(Capacity), "work-stealing capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= sizeof(long long),
+                  "items are moved with single atomic loads and stores");
+
+public:
+    Queue() { clear(); }
+
+    // Not thread-safe: only call while no thief is running
+    void clear() { top = 0; bottom = 0; }
+    static constexpr unsigned capacity() { return Capacity; }
+
+    // Owner side
+    bool push(const T& item) {
+        long long b = __atomic_load_n(&bottom, __ATOMIC_RELAXED);
+        long long t = __atomic_load_n(&top, __ATOMIC_ACQUIRE);
+        if (b - t >= (long long)Capacity) return false;
+
+        __atomic_store(&items[b & (Capacity - 1)], &item, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&bottom, b + 1, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    // Owner side, newest first
+    bool pop(T& item) {
+        long long b = __atomic_load_n(&bottom, __ATOMIC_RELAXED) - 1;
+        __atomic_store_n(&bottom, b, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        long long t = __atomic_load_n(&top, __ATOMIC_RELAXED);
+
+        if (t > b) {
+            __atomic_store_n(&bottom, b + 1, __ATOMIC_RELAXED);
+            return false;
+        }
+
+        __atomic_load(&items[b & (Capacity - 1)], &item, __ATOMIC_RELAXED);
+        if (t < b) return true;
+
+        // Last item: whoever moves top first gets it
+        bool won = __atomic_compare_exchange_n(&top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+        __atomic_store_n(&bottom, b + 1, __ATOMIC_RELAXED);
+        return won;
+    }
+
+    // Any thread, oldest first. Also false when another thread won the race for the item.
+    bool steal(T& item) {
+        long long t = __atomic_load_n(&top, __ATOMIC_ACQUIRE);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        long long b = __atomic_load_n(&bottom, __ATOMIC_ACQUIRE);
+        if (t >= b) return false;
+
+        __atomic_load(&items[t & (Capacity - 1)], &item, __ATOMIC_RELAXED);
+        return __atomic_compare_exchange_n(&top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+    }
+
+    // Approximate while thieves are running
+    unsigned size() const {
+        long long n = __atomic_load_n(&bottom, __ATOMIC_ACQUIRE) - __atomic_load_n(&top, __ATOMIC_ACQUIRE);
+        return n > 0 ? (unsigned)n : 0;
+    }
+
+private:
+    alignas(CACHE_LINE_SIZE) long long top;     // Advanced by thieves, and by the owner taking the last item
+    alignas(CACHE_LINE_SIZE) long long bottom;  // Written by the owner only
+    alignas(CACHE_LINE_SIZE) T items[Capacity];
+};
+
+} // namespace sim
+
+#endif
@@ -0,0 +1,41 @@
+#include "rng.h"
+
+static Uint64 splitmix64(Uint64 *state) {
+    Uint64 z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static Uint64 rotl(Uint64 x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+void seedRng(Rng *rng, Uint64 seed, Uint64 stream) {
+    // Mix the stream id in first so neighbouring ids give unrelated states
+    Uint64 mixer = stream;
+    Uint64 state = seed ^ splitmix64(&mixer);
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&state);
+    }
+}
+
+Uint64 rngNext(Rng *rng) {
+    Uint64 *s = rng->s;
+    Uint64 result = rotl(s[1] * 5, 7) * 9;
+    Uint64 t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+// Uniform in [0, bound) using the high 32 bits (multiply-shift, bias below 2^-32)
+Uint32 rngBelow(Rng *rng, Uint32 bound) {
+    return (Uint32)(((rngNext(rng) >> 32) * bound) >> 32);
+}
@@ -0,0 +1,17 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <SDL2/SDL_stdinc.h>
+
+// xoshiro256** generator. Streams are derived from (seed, stream id) through
+// splitmix64, so every stream is reproducible on its own and never shares state.
+typedef struct {
+    Uint64 s[4];
+} Rng;
+
+// RNG functions
+void seedRng(Rng* rng, Uint64 seed, Uint64 stream);
+Uint64 rngNext(Rng* rng);
+Uint32 rngBelow(Rng* rng, Uint32 bound);
+
+#endif
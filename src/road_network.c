@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <string.h>
+#include "road_network.h"
+
+static void *allocArray(size_t count, size_t size) {
+    return count > 0 ? simAlloc(count * size) : NULL;
+}
+
+bool initRoadNetwork(RoadNetwork *roads, int nodeCount, int linkCount) {
+    memset(roads, 0, sizeof(*roads));
+    if (nodeCount < 1 || linkCount < 0) {
+        printf("A road network needs at least one node\n");
+        return false;
+    }
+
+    roads->nodeCount = nodeCount;
+    roads->linkCount = linkCount;
+    roads->nodeX = (float *)allocArray(nodeCount, sizeof(float));
+    roads->nodeY = (float *)allocArray(nodeCount, sizeof(float));
+    roads->signalGroups = (Uint8 *)allocArray(nodeCount, sizeof(Uint8));
+    roads->linkFrom = (int *)allocArray(linkCount, sizeof(int));
+    roads->linkTo = (int *)allocArray(linkCount, sizeof(int));
+    roads->linkLength = (float *)allocArray(linkCount, sizeof(float));
+    roads->linkLanes = (Uint8 *)allocArray(linkCount, sizeof(Uint8));
+    roads->linkSignal = (Sint8 *)allocArray(linkCount, sizeof(Sint8));
+    return true;
+}
+
+// Counting sort of the links by one endpoint: O(nodes + links), no scratch memory.
+// Counts land one slot ahead, the prefix sum turns them into ends, and placing each
+// link advances its node's cursor from its start to its end, so a shift restores the starts.
+static void buildAdjacency(int nodeCount, int linkCount, const int *endpoint, int *start, int *links) {
+    memset(start, 0, sizeof(int) * (nodeCount + 1));
+    for (int l = 0; l < linkCount; l++) {
+        start[endpoint[l] + 1]++;
+    }
+    for (int n = 0; n < nodeCount; n++) {
+        start[n + 1] += start[n];
+    }
+    for (int l = 0; l < linkCount; l++) {
+        links[start[endpoint[l]]++] = l;
+    }
+    for (int n = nodeCount; n > 0; n--) {
+        start[n] = start[n - 1];
+    }
+    start[0] = 0;
+}
+
+// Checks every link, then builds the adjacency, the signal groups and the lane queues
+bool indexRoadNetwork(RoadNetwork *roads) {
+    for (int l = 0; l < roads->linkCount; l++) {
+        if (roads->linkFrom[l] < 0 || roads->linkFrom[l] >= roads->nodeCount ||
+            roads->linkTo[l] < 0 || roads->linkTo[l] >= roads->nodeCount ||
+            roads->linkFrom[l] == roads->linkTo[l]) {
+            printf("Link %d joins nodes %d and %d, which isn't a road\n", l, roads->linkFrom[l], roads->linkTo[l]);
+            return false;
+        }
+        if (!(roads->linkLength[l] > 0.0f) || roads->linkLanes[l] < 1 || roads->linkLanes[l] > ROAD_MAX_LANES ||
+            roads->linkSignal[l] < ROAD_NO_SIGNAL || roads->linkSignal[l] >= ROAD_MAX_SIGNAL_GROUPS) {
+            printf("Link %d has a bad length, lane count or signal group\n", l);
+            return false;
+        }
+    }
+
+    roads->outStart = (int *)simAlloc(sizeof(int) * (roads->nodeCount + 1));
+    roads->inStart = (int *)simAlloc(sizeof(int) * (roads->nodeCount + 1));
+    roads->outLinks = (int *)allocArray(roads->linkCount, sizeof(int));
+    roads->inLinks = (int *)allocArray(roads->linkCount, sizeof(int));
+    buildAdjacency(roads->nodeCount, roads->linkCount, roads->linkFrom, roads->outStart, roads->outLinks);
+    buildAdjacency(roads->nodeCount, roads->linkCount, roads->linkTo, roads->inStart, roads->inLinks);
+
+    // A node has as many signal groups as the highest one its incoming links use
+    memset(roads->signalGroups, 0, roads->nodeCount);
+    for (int l = 0; l < roads->linkCount; l++) {
+        Uint8 *groups = &roads->signalGroups[roads->linkTo[l]];
+        if (roads->linkSignal[l] >= *groups) {
+            *groups = (Uint8)(roads->linkSignal[l] + 1);
+        }
+    }
+
+    roads->laneStart = (int *)simAlloc(sizeof(int) * (roads->linkCount + 1));
+    roads->laneStart[0] = 0;
+    for (int l = 0; l < roads->linkCount; l++) {
+        roads->laneStart[l + 1] = roads->laneStart[l] + roads->linkLanes[l];
+    }
+    roads->laneCount = roads->laneStart[roads->linkCount];
+
+    roads->lanes = (Queue **)allocArray(roads->laneCount, sizeof(Queue *));
+    if (roads->laneCount > 0) {
+        memset(roads->lanes, 0, sizeof(Queue *) * roads->laneCount);
+    }
+    initPool(&roads->lanePool, sizeof(Queue), POOL_SLAB_BLOCKS);
+    return true;
+}
+
+Queue *roadLane(RoadNetwork *roads, int link, int lane) {
+    Queue **slot = &roads->lanes[roads->laneStart[link] + lane];
+    if (!*slot) {
+        *slot = (Queue *)poolAlloc(&roads->lanePool);
+        initQueue(*slot);
+    }
+    return *slot;
+}
+
+void freeRoadNetwork(RoadNetwork *roads) {
+    for (int i = 0; i < roads->laneCount; i++) {
+        if (roads->lanes[i]) {
+            freeQueue(roads->lanes[i]);
+        }
+    }
+    destroyPool(&roads->lanePool);
+    simFree(roads->nodeX);
+    simFree(roads->nodeY);
+    simFree(roads->signalGroups);
+    simFree(roads->linkFrom);
+    simFree(roads->linkTo);
+    simFree(roads->linkLength);
+    simFree(roads->linkLanes);
+    simFree(roads->linkSignal);
+    simFree(roads->outStart);
+    simFree(roads->outLinks);
+    simFree(roads->inStart);
+    simFree(roads->inLinks);
+    simFree(roads->laneStart);
+    simFree(roads->lanes);
+    memset(roads, 0, sizeof(*roads));
+}
+
+// The graph and its lane table, plus the lane queues created so far (not their vehicles)
+size_t roadNetworkBytes(const RoadNetwork *roads) {
+    size_t perNode = 2 * sizeof(float) + sizeof(Uint8) + 2 * sizeof(int);
+    size_t perLink = 4 * sizeof(int) + sizeof(float) + sizeof(Uint8) + sizeof(Sint8) + sizeof(int);
+    return roads->nodeCount * perNode + roads->linkCount * perLink + roads->laneCount * sizeof(Queue *) +
+           3 * sizeof(int) + (size_t)roads->lanePool.blocksInUse * roads->lanePool.blockSize;
+}
+
+// Map file reader. The whole file is read at once and scanned in a single pass with
+// hand-rolled number parsing, which keeps a million-link map well under a second.
+typedef struct {
+    const char *at;
+    const char *end;
+    int line;
+} MapReader;
+
+// Skips whitespace and # comments
+static bool nextToken(MapReader *reader) {
+    while (reader->at < reader->end) {
+        char c = *reader->at;
+        if (c == '\n') {
+            reader->line++;
+        } else if (c == '#') {
+            while (reader->at < reader->end && *reader->at != '\n') reader->at++;
+            continue;
+        } else if (c != ' ' && c != '\t' && c != '\r') {
+            return true;
+        }
+        reader->at++;
+    }
+    return false;
+}
+
+static bool readWord(MapReader *reader, const char *word) {
+    size_t length = strlen(word);
+    if (!nextToken(reader) || (size_t)(reader->end - reader->at) < length ||
+        memcmp(reader->at, word, length) != 0) {
+        return false;
+    }
+    const char *after = reader->at + length;
+    if (after < reader->end && *after > ' ' && *after != '#') return false;
+    reader->at = after;
+    return true;
+}
+
+static bool readInt(MapReader *reader, int *value) {
+    if (!nextToken(reader)) return false;
+    bool negative = *reader->at == '-';
+    if (negative) reader->at++;
+
+    long long result = 0;
+    const char *digits = reader->at;
+    while (reader->at < reader->end && *reader->at >= '0' && *reader->at <= '9') {
+        result = result * 10 + (*reader->at++ - '0');
+        if (result > 0x7fffffff) return false;
+    }
+    if (reader->at == digits) return false;
+    *value = (int)(negative ? -result : result);
+    return true;
+}
+
+static bool readFloat(MapReader *reader, float *value) {
+    if (!nextToken(reader)) return false;
+    bool negative = *reader->at == '-';
+    if (negative) reader->at++;
+
+    double result = 0.0;
+    const char *digits = reader->at;
+    while (reader->at < reader->end && *reader->at >= '0' && *reader->at <= '9') {
+        result = result * 10.0 + (*reader->at++ - '0');
+    }
+    if (reader->at < reader->end && *reader->at == '.') {
+        reader->at++;
+        double scale = 0.1;
+        while (reader->at < reader->end && *reader->at >= '0' && *reader->at <= '9') {
+            result += (*reader->at++ - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    if (reader->at == digits) return false;
+    *value = (float)(negative ? -result : result);
+    return true;
+}
+
+static bool parseMap(RoadNetwork *roads, MapReader *reader) {
+    int nodeCount, linkCount;
+    if (!readWord(reader, "nodes") || !readInt(reader, &nodeCount) ||
+        !readWord(reader, "links") || !readInt(reader, &linkCount)) {
+        printf("Map line %d: expected 'nodes N' and 'links M' first\n", reader->line);
+        return false;
+    }
+    if (!initRoadNetwork(roads, nodeCount, linkCount)) {
+        return false;
+    }
+
+    for (int n = 0; n < nodeCount; n++) {
+        if (!readWord(reader, "n") || !readFloat(reader, &roads->nodeX[n]) || !readFloat(reader, &roads->nodeY[n])) {
+            printf("Map line %d: expected node %d as 'n X Y'\n", reader->line, n);
+            return false;
+        }
+    }
+
+    for (int l = 0; l < linkCount; l++) {
+        int lanes, signal;
+        if (!readWord(reader, "l") || !readInt(reader, &roads->linkFrom[l]) || !readInt(reader, &roads->linkTo[l]) ||
+            !readFloat(reader, &roads->linkLength[l]) || !readInt(reader, &lanes) || !readInt(reader, &signal)) {
+            printf("Map line %d: expected link %d as 'l FROM TO LENGTH LANES SIGNAL'\n", reader->line, l);
+            return false;
+        }
+        roads->linkLanes[l] = (Uint8)(lanes < 0 || lanes > 255 ? 0 : lanes);
+        roads->linkSignal[l] = (Sint8)(signal < -128 || signal > 127 ? -128 : signal);
+    }
+
+    if (nextToken(reader)) {
+        printf("Map line %d: more records than the counts at the top\n", reader->line);
+        return false;
+    }
+    return indexRoadNetwork(roads);
+}
+
+bool loadRoadNetwork(RoadNetwork *roads, const char *path) {
+    memset(roads, 0, sizeof(*roads));
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        printf("Failed to open map %s\n", path);
+        return false;
+    }
+
+    // Size it from the end, then check a byte can really be read: a directory opens
+    // fine on some systems and reports a nonsense size
+    long size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    bool readable = size >= 0 && fseek(file, 0, SEEK_SET) == 0 &&
+                    (size == 0 || fgetc(file) != EOF) && fseek(file, 0, SEEK_SET) == 0;
+    if (!readable) {
+        printf("Cannot read map file %s\n", path);
+        fclose(file);
+        return false;
+    }
+
+    char *text = (char *)simAlloc(size > 0 ? size : 1);
+    bool read = size >= 0 && fread(text, 1, size, file) == (size_t)size;
+    fclose(file);
+    if (!read) {
+        printf("Failed to read map %s\n", path);
+        simFree(text);
+        return false;
+    }
+
+    MapReader reader = {text, text + size, 1};
+    bool loaded = parseMap(roads, &reader);
+    simFree(text);
+    if (!loaded) {
+        freeRoadNetwork(roads);
+    }
+    return loaded;
+}
@@ -0,0 +1,53 @@
+#ifndef ROAD_NETWORK_H
+#define ROAD_NETWORK_H
+
+#include "traffic_simulation.h"
+
+// Map limits: lanes per link and signal groups per junction
+#define ROAD_MAX_LANES 8
+#define ROAD_MAX_SIGNAL_GROUPS 8
+#define ROAD_NO_SIGNAL (-1)
+
+// Road graph loaded from a map file, stored as parallel arrays (one per field).
+// Adjacency is compressed sparse row: the links leaving node n are
+// outLinks[outStart[n]] .. outLinks[outStart[n + 1] - 1], and likewise for inLinks.
+// Lanes are numbered link by link: the lanes of link l are lanes[laneStart[l]] ..
+// lanes[laneStart[l + 1] - 1], each an ordinary lane queue from lanePool, created the
+// first time roadLane asks for it so a big map costs one pointer per idle lane.
+typedef struct {
+    int nodeCount;
+    int linkCount;
+    int laneCount;
+
+    // Nodes
+    float* nodeX;
+    float* nodeY;
+    Uint8* signalGroups;   // Signal groups at each node, 0 if unsignalised
+
+    // Links
+    int* linkFrom;
+    int* linkTo;
+    float* linkLength;
+    Uint8* linkLanes;
+    Sint8* linkSignal;     // Signal group at the downstream node, or ROAD_NO_SIGNAL
+
+    // Adjacency and lanes, built by indexRoadNetwork
+    int* outStart;
+    int* outLinks;
+    int* inStart;
+    int* inLinks;
+    int* laneStart;
+    Queue** lanes;
+    Pool lanePool;
+} RoadNetwork;
+
+// Road network functions. A network is either loaded from a file, or allocated with
+// initRoadNetwork, filled in node by node and link by link, then indexed.
+bool initRoadNetwork(RoadNetwork* roads, int nodeCount, int linkCount);
+bool indexRoadNetwork(RoadNetwork* roads);
+bool loadRoadNetwork(RoadNetwork* roads, const char* path);
+void freeRoadNetwork(RoadNetwork* roads);
+Queue* roadLane(RoadNetwork* roads, int link, int lane);
+size_t roadNetworkBytes(const RoadNetwork* roads);
+
+#endif
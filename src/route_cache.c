@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "route_cache.h"
+
+// Turn from one link onto the next, from the node positions. Screen coordinates
+// (y grows downwards), as everywhere else, so a left turn has a negative cross product.
+int linkTurn(const RoadNetwork *roads, int from, int to) {
+    float ax = roads->nodeX[roads->linkTo[from]] - roads->nodeX[roads->linkFrom[from]];
+    float ay = roads->nodeY[roads->linkTo[from]] - roads->nodeY[roads->linkFrom[from]];
+    float bx = roads->nodeX[roads->linkTo[to]] - roads->nodeX[roads->linkFrom[to]];
+    float by = roads->nodeY[roads->linkTo[to]] - roads->nodeY[roads->linkFrom[to]];
+    float cross = ax * by - ay * bx;
+    float dot = ax * bx + ay * by;
+
+    // More than 30 degrees either way is a turn
+    float lengths = (ax * ax + ay * ay) * (bx * bx + by * by);
+    if (cross * cross > 0.25f * lengths) {
+        return cross < 0.0f ? TURN_LEFT : TURN_RIGHT;
+    }
+    return dot > 0.0f ? TURN_STRAIGHT : ROUTE_U_TURN;
+}
+
+static bool movementAllowed(const RouteCache *cache, int from, int to) {
+    return (cache->allowedTurns & ROUTE_TURN(linkTurn(cache->roads, from, to))) != 0;
+}
+
+static int hopLink(const RouteCache *cache, int link, Uint8 hop) {
+    const RoadNetwork *roads = cache->roads;
+    return roads->outLinks[roads->outStart[roads->linkTo[link]] + hop];
+}
+
+// Dijkstra over the reversed link graph from whatever is on the frontier. distance[l]
+// is the cost from the end of l to the end of the destination, so reaching l's
+// successor m costs cost[m] + distance[m]. The heap is a max-heap: keys are negated.
+static void settle(const RouteCache *cache, Uint8 *hop, float *distance, RouteScratch *scratch) {
+    const RoadNetwork *roads = cache->roads;
+    while (scratch->frontier.size > 0) {
+        int m = pqPop(&scratch->frontier);
+        float through = cache->cost[m] + distance[m];
+        int node = roads->linkFrom[m];
+
+        for (int k = roads->inStart[node]; k < roads->inStart[node + 1]; k++) {
+            int l = roads->inLinks[k];
+            if (through < distance[l] && movementAllowed(cache, l, m)) {
+                distance[l] = through;
+                hop[l] = cache->outSlot[m];
+                pqUpdate(&scratch->frontier, l, -through);
+                scratch->entryUpdates++;
+            }
+        }
+    }
+}
+
+static void buildTable(RouteCache *cache, int destination, RouteScratch *scratch) {
+    int links = cache->roads->linkCount;
+    Uint8 *hop = cache->nextHop + (size_t)destination * links;
+    float *distance = cache->distance + (size_t)destination * links;
+
+    memset(hop, ROUTE_NO_HOP, links);
+    for (int l = 0; l < links; l++) {
+        distance[l] = INFINITY;
+    }
+
+    int target = cache->destinations[destination];
+    distance[target] = 0.0f;
+    pqUpdate(&scratch->frontier, target, 0.0f);
+    settle(cache, hop, distance, scratch);
+}
+
+static void repairTable(RouteCache *cache, int destination, RouteScratch *scratch) {
+    const RoadNetwork *roads = cache->roads;
+    int links = roads->linkCount;
+    Uint8 *hop = cache->nextHop + (size_t)destination * links;
+    float *distance = cache->distance + (size_t)destination * links;
+    int invalidCount = 0;
+
+    // Clear every route through a link that got dearer, following next hops backwards
+    for (int c = 0; c < cache->changedCount; c++) {
+        int m = cache->changed[c];
+        if (cache->cost[m] <= cache->builtCost[m]) continue;
+
+        int scan = invalidCount;
+        scratch->invalid[invalidCount++] = m;
+        for (; scan < invalidCount; scan++) {
+            int through = scratch->invalid[scan];
+            int node = roads->linkFrom[through];
+            for (int k = roads->inStart[node]; k < roads->inStart[node + 1]; k++) {
+                int l = roads->inLinks[k];
+                if (hop[l] != ROUTE_NO_HOP && hopLink(cache, l, hop[l]) == through) {
+                    hop[l] = ROUTE_NO_HOP;
+                    distance[l] = INFINITY;
+                    scratch->invalid[invalidCount++] = l;
+                    scratch->entryUpdates++;
+                }
+            }
+        }
+    }
+
+    // Cleared links pick the best neighbour that still has a route. The dearer links
+    // themselves are on the list too, but keep their own routes.
+    for (int i = 0; i < invalidCount; i++) {
+        int l = scratch->invalid[i];
+        if (distance[l] != INFINITY) continue;
+        int node = roads->linkTo[l];
+        for (int k = roads->outStart[node]; k < roads->outStart[node + 1]; k++) {
+            int m = roads->outLinks[k];
+            float through = cache->cost[m] + distance[m];
+            if (through < distance[l] && movementAllowed(cache, l, m)) {
+                distance[l] = through;
+                hop[l] = (Uint8)(k - roads->outStart[node]);
+            }
+        }
+        if (hop[l] != ROUTE_NO_HOP) {
+            pqUpdate(&scratch->frontier, l, -distance[l]);
+        }
+    }
+
+    // Links that got cheaper may now be the better way on for the links feeding them
+    for (int c = 0; c < cache->changedCount; c++) {
+        int m = cache->changed[c];
+        if (distance[m] == INFINITY) continue;
+        float through = cache->cost[m] + distance[m];
+        int node = roads->linkFrom[m];
+        for (int k = roads->inStart[node]; k < roads->inStart[node + 1]; k++) {
+            int l = roads->inLinks[k];
+            if (through < distance[l] && movementAllowed(cache, l, m)) {
+                distance[l] = through;
+                hop[l] = cache->outSlot[m];
+                pqUpdate(&scratch->frontier, l, -through);
+                scratch->entryUpdates++;
+            }
+        }
+    }
+
+    settle(cache, hop, distance, scratch);
+}
+
+// Task t builds or repairs every scratchCount-th table with scratch t
+static void buildTables(void *context, int index) {
+    RouteCache *cache = (RouteCache *)context;
+    for (int d = index; d < cache->destinationCount; d += cache->scratchCount) {
+        buildTable(cache, d, &cache->scratch[index]);
+    }
+}
+
+static void repairTables(void *context, int index) {
+    RouteCache *cache = (RouteCache *)context;
+    for (int d = index; d < cache->destinationCount; d += cache->scratchCount) {
+        repairTable(cache, d, &cache->scratch[index]);
+    }
+}
+
+bool initRouteCache(RouteCache *cache, const RoadNetwork *roads, const int *destinations, int destinationCount,
+                    const float *cost, Uint8 allowedTurns, WorkerPool *workers) {
+    int links = roads->linkCount;
+    memset(cache, 0, sizeof(*cache));
+    if (destinationCount < 1 || destinationCount >= 0xFFFF) {
+        printf("Routes need between 1 and %d destinations\n", 0xFFFF - 1);
+        return false;
+    }
+
+    cache->outSlot = (Uint8 *)simAlloc(links > 0 ? links : 1);
+    for (int n = 0; n < roads->nodeCount; n++) {
+        if (roads->outStart[n + 1] - roads->outStart[n] >= ROUTE_NO_HOP) {
+            printf("Node %d has too many links leaving it to route through\n", n);
+            simFree(cache->outSlot);
+            cache->outSlot = NULL;
+            return false;
+        }
+        for (int k = roads->outStart[n]; k < roads->outStart[n + 1]; k++) {
+            cache->outSlot[roads->outLinks[k]] = (Uint8)(k - roads->outStart[n]);
+        }
+    }
+
+    cache->roads = roads;
+    cache->allowedTurns = allowedTurns;
+    cache->destinationCount = destinationCount;
+    cache->destinations = (int *)simAlloc(sizeof(int) * destinationCount);
+    memcpy(cache->destinations, destinations, sizeof(int) * destinationCount);
+    cache->cost = (float *)simAlloc(sizeof(float) * links);
+    memcpy(cache->cost, cost, sizeof(float) * links);
+    cache->builtCost = (float *)simAlloc(sizeof(float) * links);
+    memcpy(cache->builtCost, cost, sizeof(float) * links);
+    cache->changed = (int *)simAlloc(sizeof(int) * links);
+    cache->isChanged = (Uint8 *)simAlloc(links);
+    memset(cache->isChanged, 0, links);
+
+    size_t entries = (size_t)destinationCount * links;
+    cache->nextHop = (Uint8 *)simAlloc(entries);
+    cache->distance = (float *)simAlloc(sizeof(float) * entries);
+
+    cache->scratchCount = workers->threadCount + 1;
+    for (int t = 0; t < cache->scratchCount; t++) {
+        initPriorityQueue(&cache->scratch[t].frontier, links);
+        cache->scratch[t].invalid = (int *)simAlloc(sizeof(int) * 2 * (links > 0 ? links : 1));
+    }
+
+    int tasks = destinationCount < cache->scratchCount ? destinationCount : cache->scratchCount;
+    runParallel(workers, buildTables, cache, tasks);
+    for (int t = 0; t < cache->scratchCount; t++) {
+        cache->scratch[t].entryUpdates = 0;
+    }
+    return true;
+}
+
+void freeRouteCache(RouteCache *cache) {
+    for (int t = 0; t < cache->scratchCount; t++) {
+        freePriorityQueue(&cache->scratch[t].frontier);
+        simFree(cache->scratch[t].invalid);
+    }
+    simFree(cache->destinations);
+    simFree(cache->cost);
+    simFree(cache->builtCost);
+    simFree(cache->changed);
+    simFree(cache->isChanged);
+    simFree(cache->outSlot);
+    simFree(cache->nextHop);
+    simFree(cache->distance);
+    memset(cache, 0, sizeof(*cache));
+}
+
+// Records the new cost for the next recomputeRoutes; small changes are ignored
+void updateLinkCost(RouteCache *cache, int link, float cost) {
+    float change = fabsf(cost - cache->builtCost[link]);
+    if (change <= ROUTE_COST_CHANGE * cache->builtCost[link] || change <= ROUTE_MIN_COST_CHANGE) return;
+
+    cache->cost[link] = cost;
+    if (!cache->isChanged[link]) {
+        cache->isChanged[link] = 1;
+        cache->changed[cache->changedCount++] = link;
+    }
+}
+
+// Brings every table up to date with the costs changed since the last call, in parallel,
+// and returns how many links changed. Each table only depends on the costs, so the result
+// is the same for any thread count.
+int recomputeRoutes(RouteCache *cache, WorkerPool *workers) {
+    int changes = cache->changedCount;
+    if (changes == 0) return 0;
+
+    int tasks = cache->destinationCount < cache->scratchCount ? cache->destinationCount : cache->scratchCount;
+    if (changes * ROUTE_REBUILD_FRACTION > cache->roads->linkCount) {
+        runParallel(workers, buildTables, cache, tasks);
+        cache->rebuilds++;
+    } else {
+        runParallel(workers, repairTables, cache, tasks);
+        cache->repairs++;
+    }
+
+    for (int c = 0; c < changes; c++) {
+        int link = cache->changed[c];
+        cache->builtCost[link] = cache->cost[link];
+        cache->isChanged[link] = 0;
+    }
+    cache->changedCount = 0;
+
+    cache->entryUpdates = 0;
+    for (int t = 0; t < cache->scratchCount; t++) {
+        cache->entryUpdates += cache->scratch[t].entryUpdates;
+    }
+    return changes;
+}
+
+// Link to take at the end of this one towards the destination, -1 if there is none. O(1).
+int routeNextLink(const RouteCache *cache, int link, int destination) {
+    const RoadNetwork *roads = cache->roads;
+    Uint8 hop = cache->nextHop[(size_t)destination * roads->linkCount + link];
+    if (hop == ROUTE_NO_HOP) return -1;
+    return roads->outLinks[roads->outStart[roads->linkTo[link]] + hop];
+}
@@ -0,0 +1,63 @@
+#ifndef ROUTE_CACHE_H
+#define ROUTE_CACHE_H
+
+#include "road_network.h"
+#include "worker_pool.h"
+
+#define ROUTE_NO_HOP 0xFF         // At the destination, or it's out of reach
+#define ROUTE_COST_CHANGE 0.25f       // Relative change in a link's cost worth repairing routes for...
+#define ROUTE_MIN_COST_CHANGE 2.0f    // ...and absolute, so short queues ticking up and down don't count
+#define ROUTE_REBUILD_FRACTION 8      // Rebuild outright once more than 1 in this many links changed
+
+// Movements at a junction: TurnDirection values, plus turning back the way a link came
+#define ROUTE_U_TURN 3
+#define ROUTE_TURN(turn) (1 << (turn))
+
+// Scratch for one parallel task
+typedef struct {
+    PriorityQueue frontier;
+    int* invalid;           // Dearer links, then the links whose route went through them
+    unsigned long entryUpdates;
+} RouteScratch;
+
+// Next-hop tables towards a set of destination links. For destination d and link l,
+// entry d * linkCount + l says which link to take at the end of l, as its position
+// among the links leaving l's downstream node, so following a route is one byte
+// lookup per junction. Each table starts from a Dijkstra run outwards from its
+// destination over the reversed link graph; tables are independent, so they are built
+// and repaired in parallel on the worker pool.
+// When costs change, a table is repaired rather than rebuilt: routes through a link
+// that got dearer are cleared back to where they start and re-seeded from their
+// neighbours, links that got cheaper seed the links feeding them, and Dijkstra carries
+// on from those seeds only. When a large share of links changed at once, a repair would
+// touch nearly every entry anyway, so the tables are rebuilt instead.
+typedef struct {
+    const RoadNetwork* roads;
+    Uint8 allowedTurns;         // ROUTE_TURN bits of the movements routes may use
+    int destinationCount;
+    int* destinations;          // Link that completes each destination
+    float* cost;                // Per link: current travel cost
+    float* builtCost;           // Per link: cost the tables were last repaired with
+    Uint8* outSlot;             // Per link: position among the links leaving its upstream node
+    Uint8* nextHop;             // Per destination and link
+    float* distance;            // Per destination and link: cost from the end of the link on
+    int* changed;               // Links whose cost changed since the last repair
+    int changedCount;
+    Uint8* isChanged;
+    RouteScratch scratch[WORKER_POOL_MAX_THREADS + 1];
+    int scratchCount;
+    unsigned long entryUpdates; // Table entries recomputed after cost changes over the whole run
+    int repairs;                // recomputeRoutes calls that repaired the tables
+    int rebuilds;               // ...and that rebuilt them
+} RouteCache;
+
+// Route cache functions
+int linkTurn(const RoadNetwork* roads, int from, int to);
+bool initRouteCache(RouteCache* cache, const RoadNetwork* roads, const int* destinations, int destinationCount,
+                    const float* cost, Uint8 allowedTurns, WorkerPool* workers);
+void freeRouteCache(RouteCache* cache);
+void updateLinkCost(RouteCache* cache, int link, float cost);
+int recomputeRoutes(RouteCache* cache, WorkerPool* workers);
+int routeNextLink(const RouteCache* cache, int link, int destination);
+
+#endif
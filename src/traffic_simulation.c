@@ -1,325 +1,550 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
 #include "traffic_simulation.h"
+#include "motion.h"
+#include "network.h"
+
+Pool vehiclePool;
+
+const VehicleProfile vehicleProfiles[VEHICLE_PROFILE_COUNT] = {
+    {REGULAR_CAR, {255, 182, 193, 255}},   // Light Pink
+    {REGULAR_CAR, {173, 216, 230, 255}},   // Light Blue
+    {REGULAR_CAR, {144, 238, 144, 255}},   // Light Green
+    {REGULAR_CAR, {255, 255, 224, 255}},   // Light Yellow
+    {REGULAR_CAR, {221, 160, 221, 255}},   // Plum
+    {REGULAR_CAR, {176, 224, 230, 255}},   // Powder Blue
+    {REGULAR_CAR, {255, 218, 185, 255}},   // Peach
+    {REGULAR_CAR, {216, 191, 216, 255}},   // Thistle
+};
 
-Queue laneQueues[4];
-
-const SDL_Color VEHICLE_COLORS[] = {
-    {255, 182, 193, 255},   // Light Pink
-    {173, 216, 230, 255},   // Light Blue
-    {144, 238, 144, 255},   // Light Green
-    {255, 255, 224, 255},   // Light Yellow
-    {221, 160, 221, 255},   // Plum
-    {176, 224, 230, 255},   // Powder Blue
-    {255, 218, 185, 255},   // Peach
-    {216, 191, 216, 255},   // Thistle
+const VehicleRoute NO_ROUTE = {VEHICLE_NO_ROUTE, VEHICLE_NO_ROUTE};
+
+constexpr ApproachGeometry APPROACHES[4] = {
+    {"NORTH",
+     INTERSECTION_X + LANE_WIDTH / 2 - 10, WINDOW_HEIGHT + 10,
+     0.0f, -1.0f,
+     -(INTERSECTION_Y + LANE_WIDTH), -INTERSECTION_Y, 50,
+     INTERSECTION_X + LANE_WIDTH / 2 - 10, INTERSECTION_Y,
+     DIRECTION_WEST, AXIS_NORTH_SOUTH, 20, 30,
+     {INTERSECTION_X - LANE_WIDTH, INTERSECTION_Y - LANE_WIDTH - TRAFFIC_LIGHT_HEIGHT,
+      TRAFFIC_LIGHT_WIDTH, TRAFFIC_LIGHT_HEIGHT}},
+    {"SOUTH",
+     INTERSECTION_X - LANE_WIDTH / 2 - 10, -40,
+     0.0f, 1.0f,
+     INTERSECTION_Y - LANE_WIDTH, INTERSECTION_Y, WINDOW_HEIGHT + 50,
+     INTERSECTION_X - LANE_WIDTH / 2 - 10, INTERSECTION_Y,
+     DIRECTION_EAST, AXIS_NORTH_SOUTH, 20, 30,
+     {INTERSECTION_X - LANE_WIDTH, INTERSECTION_Y + LANE_WIDTH,
+      TRAFFIC_LIGHT_WIDTH, TRAFFIC_LIGHT_HEIGHT}},
+    {"EAST",
+     -40, INTERSECTION_Y + LANE_WIDTH / 2 - 10,
+     1.0f, 0.0f,
+     INTERSECTION_X - LANE_WIDTH, INTERSECTION_X, WINDOW_WIDTH + 50,
+     INTERSECTION_X, INTERSECTION_Y + LANE_WIDTH / 2 - 10,
+     DIRECTION_NORTH, AXIS_EAST_WEST, 30, 20,
+     {INTERSECTION_X + LANE_WIDTH, INTERSECTION_Y - LANE_WIDTH,
+      TRAFFIC_LIGHT_HEIGHT, TRAFFIC_LIGHT_WIDTH}},
+    {"WEST",
+     WINDOW_WIDTH + 10, INTERSECTION_Y - LANE_WIDTH / 2 - 10,
+     -1.0f, 0.0f,
+     -(INTERSECTION_X + LANE_WIDTH), -INTERSECTION_X, 50,
+     INTERSECTION_X, INTERSECTION_Y - LANE_WIDTH / 2 - 10,
+     DIRECTION_SOUTH, AXIS_EAST_WEST, 30, 20,
+     {INTERSECTION_X - LANE_WIDTH - TRAFFIC_LIGHT_HEIGHT, INTERSECTION_Y - LANE_WIDTH,
+      TRAFFIC_LIGHT_HEIGHT, TRAFFIC_LIGHT_WIDTH}},
 };
 
-void initializeTrafficLights(TrafficLight *lights) {
-    lights[0] = (TrafficLight){
-        .state = RED, .timer = 0,
-        .position = {INTERSECTION_X - LANE_WIDTH, INTERSECTION_Y - LANE_WIDTH - TRAFFIC_LIGHT_HEIGHT, 
-                    TRAFFIC_LIGHT_WIDTH, TRAFFIC_LIGHT_HEIGHT},
-        .direction = DIRECTION_NORTH
-    };
-    
-    lights[1] = (TrafficLight){
-        .state = RED, .timer = 0,
-        .position = {INTERSECTION_X - LANE_WIDTH, INTERSECTION_Y + LANE_WIDTH, 
-                    TRAFFIC_LIGHT_WIDTH, TRAFFIC_LIGHT_HEIGHT},
-        .direction = DIRECTION_SOUTH
-    };
-    
-    lights[2] = (TrafficLight){
-        .state = GREEN, .timer = 0,
-        .position = {INTERSECTION_X + LANE_WIDTH, INTERSECTION_Y - LANE_WIDTH, 
-                    TRAFFIC_LIGHT_HEIGHT, TRAFFIC_LIGHT_WIDTH},
-        .direction = DIRECTION_EAST
-    };
-    
-    lights[3] = (TrafficLight){
-        .state = GREEN, .timer = 0,
-        .position = {INTERSECTION_X - LANE_WIDTH - TRAFFIC_LIGHT_HEIGHT, INTERSECTION_Y - LANE_WIDTH, 
-                    TRAFFIC_LIGHT_HEIGHT, TRAFFIC_LIGHT_WIDTH},
-        .direction = DIRECTION_WEST
-    };
-}
-
-void updateTrafficLights(TrafficLight *lights) {
-    static Uint32 lastUpdate = 0;
-    static int cycle = 0;
-    Uint32 current = SDL_GetTicks();
-
-    if (current - lastUpdate >= 5000) {
-        lastUpdate = current;
-        cycle = !cycle;
-
-        if (cycle == 0) {
-            lights[DIRECTION_NORTH].state = GREEN;
-            lights[DIRECTION_SOUTH].state = GREEN;
-            lights[DIRECTION_EAST].state = RED;
-            lights[DIRECTION_WEST].state = RED;
-        } else {
-            lights[DIRECTION_NORTH].state = RED;
-            lights[DIRECTION_SOUTH].state = RED;
-            lights[DIRECTION_EAST].state = GREEN;
-            lights[DIRECTION_WEST].state = GREEN;
+bool simulationVerbose = true;
+SimulationClock simulationClock = {0, SIM_STEP_MS, 1.0f, 0.0};
+SimulationRandom simulationRandom;
+
+void initSimulationClock(SimulationClock *clock, Uint32 stepMs, float warp) {
+    if (warp < SIM_WARP_MIN) warp = SIM_WARP_MIN;
+    if (warp > SIM_WARP_MAX) warp = SIM_WARP_MAX;
+
+    clock->time = 0;
+    clock->stepMs = stepMs;
+    clock->warp = warp;
+    clock->pendingMs = 0.0;
+}
+
+// Adds elapsed wall time and returns how many whole steps are now due
+int accumulateWallTime(SimulationClock *clock, double wallMs) {
+    clock->pendingMs += wallMs * clock->warp;
+
+    int steps = (int)(clock->pendingMs / clock->stepMs);
+    if (steps > SIM_MAX_STEPS_PER_FRAME) {
+        // Falling behind: drop the backlog rather than stall the window
+        steps = SIM_MAX_STEPS_PER_FRAME;
+        clock->pendingMs = 0.0;
+    } else {
+        clock->pendingMs -= (double)steps * clock->stepMs;
+    }
+    return steps;
+}
+
+// Written only by the simulation loop; the arrival thread reads it
+void tickSimulationClock(SimulationClock *clock) {
+    __atomic_store_n(&clock->time, clock->time + clock->stepMs, __ATOMIC_RELEASE);
+}
+
+Uint32 getSimulationTime(void) {
+    return __atomic_load_n(&simulationClock.time, __ATOMIC_ACQUIRE);
+}
+
+void seedSimulationRandom(SimulationRandom *random, Uint64 seed) {
+    random->seed = seed;
+    seedRng(&random->intersection, seed, RNG_STREAM_INTERSECTION);
+    for (int i = 0; i < 4; i++) {
+        seedRng(&random->lanes[i], seed, RNG_STREAM_LANE(i));
+    }
+}
+
+void initializeTrafficLights(Intersection *junction) {
+    TrafficLight *lights = junction->lights;
+
+    // East-west starts green
+    for (int i = 0; i < 4; i++) {
+        lights[i].state = APPROACHES[i].axis == AXIS_EAST_WEST ? GREEN : RED;
+        lights[i].timer = 0;
+        lights[i].position = APPROACHES[i].light;
+        lights[i].direction = (Direction)i;
+    }
+
+    Uint32 now = getSimulationTime();
+    for (int i = 0; i < 4; i++) {
+        lights[i].redSince = now;
+    }
+
+    if (junction->approachPriority.capacity == 0) {
+        initPriorityQueue(&junction->approachPriority, 4);
+    }
+    for (int i = 0; i < 4; i++) {
+        pqUpdate(&junction->approachPriority, i, 0.0f);
+    }
+}
+
+static void setLight(TrafficLight *light, TrafficLightState state, Uint32 now) {
+    if (light->state != RED && state == RED) {
+        light->redSince = now;
+    }
+    light->state = state;
+}
+
+void updateTrafficLights(Intersection *junction) {
+    TrafficLight *lights = junction->lights;
+    Uint32 current = getSimulationTime();
+
+    // Congestion = queued vehicles plus weighted time spent waiting on red
+    for (int i = 0; i < 4; i++) {
+        float waited = 0.0f;
+        if (lights[i].state == RED) {
+            waited = (current - lights[i].redSince) / 1000.0f;
         }
+        pqUpdate(&junction->approachPriority, i, junction->lanes[i].size + SIGNAL_WAIT_WEIGHT * waited);
+    }
+
+    if (lights[0].timer >= SIGNAL_PHASE_MS) {
+        for (int i = 0; i < 4; i++) {
+            lights[i].timer = 0;
+        }
+
+        // The most congested approach wins the next phase for its axis
+        Axis green = APPROACHES[pqPeek(&junction->approachPriority)].axis;
+        for (int i = 0; i < 4; i++) {
+            setLight(&lights[i], APPROACHES[i].axis == green ? GREEN : RED, current);
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        lights[i].timer += simulationClock.stepMs;
     }
 }
 
-Vehicle *createVehicle(Direction direction) {
-    Vehicle *vehicle = (Vehicle *)malloc(sizeof(Vehicle));
+void initVehicle(Vehicle *vehicle, Direction direction) {
     vehicle->direction = direction;
-    vehicle->type = REGULAR_CAR;
-    vehicle->active = true;
+    vehicle->flags = VEHICLE_ACTIVE;
     vehicle->speed = 2.0f;
-    vehicle->state = STATE_MOVING;
+    vehicle->spawnTime = getSimulationTime();
     
-    int turnChance = rand() % 100;
-    if (turnChance < 15) {
+    Rng *rng = &simulationRandom.lanes[direction];
+    Uint32 turnChance = rngBelow(rng, 100);
+    if (turnChance < LEFT_TURN_PERCENT) {
         vehicle->turnDirection = TURN_LEFT;
     } else {
         vehicle->turnDirection = TURN_STRAIGHT;
     }
     
-    vehicle->colorIndex = rand() % 8;
-    vehicle->isTurning = false;
+    vehicle->profile = rngBelow(rng, VEHICLE_PROFILE_COUNT);
     vehicle->turnProgress = 0.0f;
-    vehicle->hasPassedCenter = false;
 
-    if (direction == DIRECTION_NORTH || direction == DIRECTION_SOUTH) {
-        vehicle->rect.w = 20;
-        vehicle->rect.h = 30;
-    } else {
-        vehicle->rect.w = 30;
-        vehicle->rect.h = 20;
-    }
-
-    switch (direction) {
-        case DIRECTION_NORTH:
-            vehicle->x = INTERSECTION_X + LANE_WIDTH / 2 - vehicle->rect.w / 2;
-            vehicle->y = WINDOW_HEIGHT + 10;
-            break;
-        case DIRECTION_SOUTH:
-            vehicle->x = INTERSECTION_X - LANE_WIDTH / 2 - vehicle->rect.w / 2;
-            vehicle->y = -40;
-            break;
-        case DIRECTION_EAST:
-            vehicle->x = -40;
-            vehicle->y = INTERSECTION_Y + LANE_WIDTH / 2 - vehicle->rect.h / 2;
-            break;
-        case DIRECTION_WEST:
-            vehicle->x = WINDOW_WIDTH + 10;
-            vehicle->y = INTERSECTION_Y - LANE_WIDTH / 2 - vehicle->rect.h / 2;
-            break;
-    }
-
-    vehicle->rect.x = (int)vehicle->x;
-    vehicle->rect.y = (int)vehicle->y;
-
-    enqueue(&laneQueues[direction], *vehicle);
+    vehicle->x = APPROACHES[direction].entryX;
+    vehicle->y = APPROACHES[direction].entryY;
+
+    vehicle->handle.index = 0;
+    vehicle->handle.generation = 0;
+}
+
+Vehicle *createVehicle(Direction direction) {
+    Vehicle *vehicle = (Vehicle *)poolAlloc(&vehiclePool);
+    initVehicle(vehicle, direction);
 
     return vehicle;
 }
-bool shouldStopForVehicleInQueue(Vehicle *vehicle, Direction lane) {
-    float criticalDistance = 100.0f;
-    
-    Node *current = laneQueues[lane].front;
-    while (current != NULL) {
-        Vehicle *other = &current->vehicle;
-        
-        if (!other->active || other == vehicle) {
-            current = current->next;
-            continue;
-        }
-        
-        float distance = 0;
-        bool ahead = false;
-        
-        switch (lane) {
-            case DIRECTION_NORTH:
-                distance = vehicle->y - other->y;
-                ahead = (other->y < vehicle->y) && (distance > 0);
-                break;
-            case DIRECTION_SOUTH:
-                distance = other->y - vehicle->y;
-                ahead = (other->y > vehicle->y) && (distance > 0);
-                break;
-            case DIRECTION_EAST:
-                distance = other->x - vehicle->x;
-                ahead = (other->x > vehicle->x) && (distance > 0);
-                break;
-            case DIRECTION_WEST:
-                distance = vehicle->x - other->x;
-                ahead = (other->x < vehicle->x) && (distance > 0);
-                break;
-        }
-        
-        if (ahead && distance < criticalDistance) {
-            return true;
-        }
-        
-        current = current->next;
+
+void freeVehicle(Vehicle *vehicle) {
+    poolFree(&vehiclePool, vehicle);
+}
+
+static float laneProgress(Queue *q, int slot, Direction lane) {
+    return q->x[slot] * APPROACHES[lane].headingX + q->y[slot] * APPROACHES[lane].headingY;
+}
+
+// Every left turn follows the same arc, rotated to its approach: each step advances
+// turnProgress by 0.03, turns the heading to 1.57 * turnProgress and moves 1.5 px.
+// The arc is summed once at compile time, so turning costs no sin/cos and every
+// turn ends on exactly the same pose.
+#define TURN_PROGRESS_STEP 0.03f
+#define TURN_STEP_LENGTH 1.5f
+
+constexpr int countTurnSteps() {
+    float progress = 0.0f;
+    int steps = 0;
+    while (progress < 1.0f) {
+        progress += TURN_PROGRESS_STEP;
+        steps++;
     }
-    
-    return false;
+    return steps;
 }
 
-void updateVehicle(Vehicle *vehicle, TrafficLight *lights) {
-    if (!vehicle->active) return;
-
-    float stopLine = 0;
-    bool shouldStopLight = false;
-    bool reachedCenter = false;
-    switch (vehicle->direction) {
-        case DIRECTION_NORTH:
-            stopLine = INTERSECTION_Y + LANE_WIDTH;
-            reachedCenter = (vehicle->y <= INTERSECTION_Y && !vehicle->hasPassedCenter);
-            
-            if (lights[DIRECTION_NORTH].state == RED) {
-                if (vehicle->turnDirection == TURN_LEFT) {
-                    
-                    shouldStopLight = false;
-                } else {
-                    
-                    shouldStopLight = (vehicle->y > stopLine - 80 && vehicle->y < stopLine + 10);
-                }
-            }
-            break;
-        case DIRECTION_SOUTH:
-            stopLine = INTERSECTION_Y - LANE_WIDTH;
-            reachedCenter = (vehicle->y >= INTERSECTION_Y && !vehicle->hasPassedCenter);
-            if (lights[DIRECTION_SOUTH].state == RED) {
-                if (vehicle->turnDirection == TURN_LEFT) {
-                    shouldStopLight = false;
-                } else {
-                    shouldStopLight = (vehicle->y < stopLine + 80 && vehicle->y > stopLine - 10);
-                }
-            }
-            break;
-        case DIRECTION_EAST:
-            stopLine = INTERSECTION_X - LANE_WIDTH;
-            reachedCenter = (vehicle->x >= INTERSECTION_X && !vehicle->hasPassedCenter);
-            if (lights[DIRECTION_EAST].state == RED) {
-                if (vehicle->turnDirection == TURN_LEFT) {
-                    shouldStopLight = false;
-                } else {
-                    shouldStopLight = (vehicle->x < stopLine + 80 && vehicle->x > stopLine - 10);
-                }
-            }
-            break;
-        case DIRECTION_WEST:
-            stopLine = INTERSECTION_X + LANE_WIDTH;
-            reachedCenter = (vehicle->x <= INTERSECTION_X && !vehicle->hasPassedCenter);
-            if (lights[DIRECTION_WEST].state == RED) {
-                if (vehicle->turnDirection == TURN_LEFT) {
-                    shouldStopLight = false;
-                } else {
-                    shouldStopLight = (vehicle->x > stopLine - 80 && vehicle->x < stopLine + 10);
-                }
-            }
-            break;
+static constexpr int TURN_STEPS = countTurnSteps();
+
+// Taylor series, accurate to double precision over the arc's 0 to 1.6 rad
+constexpr double seriesSin(double a) {
+    double term = a, sum = a;
+    for (int n = 1; n < 12; n++) {
+        term *= -a * a / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double seriesCos(double a) {
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 12; n++) {
+        term *= -a * a / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+// Offset after each step from where the turn starts, along and left of the approach heading
+typedef struct {
+    float forward[TURN_STEPS + 1];
+    float left[TURN_STEPS + 1];
+} TurnPath;
+
+constexpr TurnPath buildTurnPath() {
+    TurnPath path = {};
+    float progress = 0.0f;
+    double forward = 0.0, left = 0.0;
+    for (int step = 1; step <= TURN_STEPS; step++) {
+        progress += TURN_PROGRESS_STEP;
+        double angle = progress * 1.57f;
+        forward += seriesCos(angle) * TURN_STEP_LENGTH;
+        left += seriesSin(angle) * TURN_STEP_LENGTH;
+        path.forward[step] = (float)forward;
+        path.left[step] = (float)left;
+    }
+    return path;
+}
+
+static constexpr TurnPath TURN_PATH = buildTurnPath();
+
+static void placeOnTurnPath(Vehicle *vehicle, Direction approach, int step) {
+    const ApproachGeometry *a = &APPROACHES[approach];
+    // Left of heading (hx, hy) is (hy, -hx)
+    vehicle->x = a->turnX + TURN_PATH.forward[step] * a->headingX + TURN_PATH.left[step] * a->headingY;
+    vehicle->y = a->turnY + TURN_PATH.forward[step] * a->headingY - TURN_PATH.left[step] * a->headingX;
+}
+
+// Nearest vehicle ahead of / behind the index-th that was active at the snapshot, or -1
+static int leaderIndex(Queue *q, int index) {
+    for (int i = index - 1; i >= 0; i--) {
+        if (q->lastFlags[QUEUE_SLOT(q, i)] & VEHICLE_ACTIVE) return i;
+    }
+    return -1;
+}
+
+static int followerIndex(Queue *q, int index) {
+    for (int i = index + 1; i < q->size; i++) {
+        if (q->lastFlags[QUEUE_SLOT(q, i)] & VEHICLE_ACTIVE) return i;
     }
+    return -1;
+}
+
+static bool isTooClose(Queue *q, int leader, int index) {
+    float criticalDistance = 100.0f;
+    float distance = q->lastProgress[QUEUE_SLOT(q, leader)] - q->lastProgress[QUEUE_SLOT(q, index)];
+    return distance > 0 && distance < criticalDistance;
+}
+
+// Lanes are kept in spatial order, so the only vehicle that can block is the one just ahead.
+// Both positions come from the previous tick, so the answer doesn't depend on update order.
+bool shouldStopForVehicleInQueue(Queue *q, int index) {
+    int leader = leaderIndex(q, index);
+    return leader >= 0 && isTooClose(q, leader, index);
+}
+
+// Stop, restart and turn decisions for one vehicle. Acceleration, straight-line motion
+// and leaving the screen are handled for the whole range by advanceLaneRange.
+void updateVehicle(Vehicle *vehicle, TrafficLight *lights) {
+    if (!(vehicle->flags & VEHICLE_ACTIVE)) return;
+
+    const ApproachGeometry *approach = &APPROACHES[vehicle->direction];
+    float progress = vehicle->x * approach->headingX + vehicle->y * approach->headingY;
+    bool reachedCenter = progress >= approach->centerLine && !(vehicle->flags & VEHICLE_PASSED_CENTER);
+
+    // Left turns may go on red
+    bool shouldStopLight = lights[vehicle->direction].state == RED &&
+                           vehicle->turnDirection != TURN_LEFT &&
+                           progress > approach->stopLine - STOP_WINDOW_BEFORE &&
+                           progress < approach->stopLine + STOP_WINDOW_AFTER;
 
     if (vehicle->turnDirection == TURN_LEFT && reachedCenter) {
-        vehicle->isTurning = true;
-        vehicle->hasPassedCenter = true;
+        vehicle->flags |= VEHICLE_TURNING | VEHICLE_PASSED_CENTER;
         vehicle->turnProgress = 0.0f;
         const char* lightState = lights[vehicle->direction].state == RED ? "RED" : "GREEN";
-        printf(">>> Vehicle TURNING LEFT on %s LIGHT from direction %d\n", lightState, vehicle->direction);
+        SIM_LOG(">>> Vehicle TURNING LEFT on %s LIGHT from direction %d\n", lightState, vehicle->direction);
     }
-    bool shouldStopVehicle = shouldStopForVehicleInQueue(vehicle, vehicle->direction);
+    bool shouldStopVehicle = (vehicle->flags & VEHICLE_BLOCKED) != 0;
     bool shouldStop = shouldStopLight || shouldStopVehicle;
 
-    if (shouldStop && !vehicle->isTurning) {
+    if (shouldStop && !(vehicle->flags & VEHICLE_TURNING)) {
         vehicle->speed = 0;
-        vehicle->state = STATE_STOPPED;
-    } else if (vehicle->state == STATE_STOPPED) {
-        vehicle->state = STATE_MOVING;
-        vehicle->speed = 0.5f;
-    } else if (vehicle->speed < 2.0f) {
-        vehicle->speed += 0.1f;
-        if (vehicle->speed > 2.0f) vehicle->speed = 2.0f;
+        vehicle->flags |= VEHICLE_STOPPED;
+    } else if (vehicle->flags & VEHICLE_STOPPED) {
+        // The motion kernel adds this step's acceleration on top
+        vehicle->flags &= ~VEHICLE_STOPPED;
+        vehicle->speed = VEHICLE_RESTART_SPEED - VEHICLE_ACCELERATION;
     }
 
-    // Movement and turning
+    // Turning; straight-line movement happens in the lane's motion kernel
     if (vehicle->speed > 0) {
-        if (vehicle->isTurning && vehicle->turnProgress < 1.0f) {
-            
-            vehicle->turnProgress += 0.03f;
-            float angle = vehicle->turnProgress * 1.57f;
-            
-            Direction originalDir = vehicle->direction;
-            
-            switch (originalDir) {
-                case DIRECTION_NORTH:
-                    vehicle->x -= sin(angle) * 1.5f;
-                    vehicle->y -= cos(angle) * 1.5f;
-                    if (vehicle->turnProgress >= 1.0f) {
-                        vehicle->direction = DIRECTION_WEST;
-                        vehicle->rect.w = 30;
-                        vehicle->rect.h = 20;
-                        vehicle->isTurning = false;
-                        printf("<<< Completed turn: NORTH -> WEST\n");
-                    }
-                    break;
-                    
-                case DIRECTION_SOUTH:
-                    vehicle->x += sin(angle) * 1.5f;
-                    vehicle->y += cos(angle) * 1.5f;
-                    if (vehicle->turnProgress >= 1.0f) {
-                        vehicle->direction = DIRECTION_EAST;
-                        vehicle->rect.w = 30;
-                        vehicle->rect.h = 20;
-                        vehicle->isTurning = false;
-                        printf("<<< Completed turn: SOUTH -> EAST\n");
-                    }
-                    break;
-                    
-                case DIRECTION_EAST:
-                    vehicle->x += cos(angle) * 1.5f;
-                    vehicle->y -= sin(angle) * 1.5f;
-                    if (vehicle->turnProgress >= 1.0f) {
-                        vehicle->direction = DIRECTION_NORTH;
-                        vehicle->rect.w = 20;
-                        vehicle->rect.h = 30;
-                        vehicle->isTurning = false;
-                        printf("<<< Completed turn: EAST -> NORTH\n");
-                    }
-                    break;
-                    
-                case DIRECTION_WEST:
-                    vehicle->x -= cos(angle) * 1.5f;
-                    vehicle->y += sin(angle) * 1.5f;
-                    if (vehicle->turnProgress >= 1.0f) {
-                        vehicle->direction = DIRECTION_SOUTH;
-                        vehicle->rect.w = 20;
-                        vehicle->rect.h = 30;
-                        vehicle->isTurning = false;
-                        printf("<<< Completed turn: WEST -> SOUTH\n");
-                    }
-                    break;
+        if ((vehicle->flags & VEHICLE_TURNING) && vehicle->turnProgress < 1.0f) {
+            int step = (int)(vehicle->turnProgress * TURN_STEPS + 0.5f) + 1;
+            vehicle->turnProgress = (float)step / TURN_STEPS;
+
+            Direction originalDir = (Direction)vehicle->direction;
+            placeOnTurnPath(vehicle, originalDir, step);
+
+            if (step == TURN_STEPS) {
+                vehicle->turnProgress = 1.0f;
+                vehicle->direction = APPROACHES[originalDir].leftTurnExit;
+                vehicle->flags &= ~VEHICLE_TURNING;
+                SIM_LOG("<<< Completed turn: %s -> %s\n",
+                        APPROACHES[originalDir].name, APPROACHES[vehicle->direction].name);
             }
-        } else if (!vehicle->isTurning) {
-            
-            switch (vehicle->direction) {
-                case DIRECTION_NORTH: vehicle->y -= vehicle->speed; break;
-                case DIRECTION_SOUTH: vehicle->y += vehicle->speed; break;
-                case DIRECTION_EAST: vehicle->x += vehicle->speed; break;
-                case DIRECTION_WEST: vehicle->x -= vehicle->speed; break;
+        }
+    }
+}
+
+static void moveSlot(Queue *dst, int to, const Queue *src, int from);
+static bool isHandleLive(Queue *q, VehicleHandle handle);
+static void loadSlot(Queue *q, int slot, Vehicle *vehicle);
+
+// Hot fields only: what updateVehicle reads and writes
+static void loadHot(Queue *q, int slot, Vehicle *vehicle) {
+    vehicle->x = q->x[slot];
+    vehicle->y = q->y[slot];
+    vehicle->speed = q->speed[slot];
+    vehicle->turnProgress = q->turnProgress[slot];
+    vehicle->direction = q->direction[slot];
+    vehicle->turnDirection = q->turnDirection[slot];
+    vehicle->flags = q->flags[slot];
+}
+
+static void storeHot(Queue *q, int slot, const Vehicle *vehicle) {
+    q->x[slot] = vehicle->x;
+    q->y[slot] = vehicle->y;
+    q->dx[slot] = APPROACHES[vehicle->direction].headingX;
+    q->dy[slot] = APPROACHES[vehicle->direction].headingY;
+    q->speed[slot] = vehicle->speed;
+    q->turnProgress[slot] = vehicle->turnProgress;
+    q->direction[slot] = vehicle->direction;
+    q->turnDirection[slot] = vehicle->turnDirection;
+    q->flags[slot] = vehicle->flags;
+}
+
+// The on-screen rect is derived from position and heading, never stored
+SDL_Rect vehicleRect(float x, float y, Direction direction) {
+    SDL_Rect rect = {(int)x, (int)y, APPROACHES[direction].width, APPROACHES[direction].height};
+    return rect;
+}
+
+// Records where every vehicle starts the tick, before any of them moves
+void snapshotLane(Queue *q, Direction lane) {
+    for (int i = 0; i < q->size; i++) {
+        int slot = QUEUE_SLOT(q, i);
+        q->lastProgress[slot] = laneProgress(q, slot, lane);
+        q->lastFlags[slot] = q->flags[slot];
+    }
+}
+
+// Updates vehicles [begin, end) from the front. Writes only their own slots and reads
+// other vehicles only through the snapshot, so disjoint ranges can run concurrently.
+// The one shared write is the lane's wake list, appended with an atomic counter.
+int updateLaneRange(Intersection *junction, Direction lane, int begin, int end) {
+    Queue *q = &junction->lanes[lane];
+    for (int i = begin; i < end; i++) {
+        int slot = QUEUE_SLOT(q, i);
+        if ((q->flags[slot] & (VEHICLE_ACTIVE | VEHICLE_DORMANT)) != VEHICLE_ACTIVE) continue;
+
+        Vehicle v;
+        loadHot(q, slot, &v);
+        int leader = leaderIndex(q, i);
+        bool blockedByLeader = leader >= 0 && isTooClose(q, leader, i);
+        // Straight movements are kept apart by the lights; left turns (even on red) yield
+        bool yieldToCrossing = v.turnDirection == TURN_LEFT &&
+                               hasCrossingConflict(&junction->conflicts, v.x, v.y, (Direction)v.direction);
+        if (blockedByLeader || yieldToCrossing) {
+            v.flags |= VEHICLE_BLOCKED;
+        } else {
+            v.flags &= ~VEHICLE_BLOCKED;
+        }
+        bool wasTurning = (v.flags & VEHICLE_TURNING) != 0;
+        bool wasStopped = (v.flags & VEHICLE_STOPPED) != 0;
+        updateVehicle(&v, junction->lights);
+
+        // Stopped behind a leader that isn't moving: nothing changes for this vehicle until
+        // the leader restarts (lights don't matter while it's blocked), so stop updating it
+        if (blockedByLeader && (v.flags & VEHICLE_STOPPED) &&
+            (q->lastFlags[QUEUE_SLOT(q, leader)] & VEHICLE_STOPPED)) {
+            v.flags |= VEHICLE_DORMANT;
+        }
+        storeHot(q, slot, &v);
+
+        if (wasStopped && !(v.flags & VEHICLE_STOPPED)) {
+            int follower = followerIndex(q, i);
+            if (follower >= 0) {
+                q->wakeList[SDL_AtomicAdd(&q->wakeCount, 1)] = QUEUE_SLOT(q, follower);
+            }
+        }
+
+        // The last turn step already moved it: no straight-line step until the next tick
+        if (wasTurning && !(v.flags & VEHICLE_TURNING)) {
+            q->dx[slot] = 0.0f;
+            q->dy[slot] = 0.0f;
+        }
+    }
+
+    return advanceLaneRange(q, begin, end);
+}
+
+int updateLane(Intersection *junction, Direction lane) {
+    Queue *q = &junction->lanes[lane];
+    snapshotLane(q, lane);
+    buildConflictGrid(&junction->conflicts, junction->lanes);
+    int exited = updateLaneRange(junction, lane, 0, q->size);
+    wakeFollowers(q);
+    return exited;
+}
+
+// Run once the lane's update is done; the follower picks up its leader's restart from
+// the next snapshot, just as it would have by checking every tick
+void wakeFollowers(Queue *q) {
+    int count = SDL_AtomicGet(&q->wakeCount);
+    for (int i = 0; i < count; i++) {
+        q->flags[q->wakeList[i]] &= ~VEHICLE_DORMANT;
+    }
+    SDL_AtomicSet(&q->wakeCount, 0);
+}
+
+static void swapQueueSlots(Queue *q, int a, int b) {
+    float x = q->x[a], y = q->y[a], dx = q->dx[a], dy = q->dy[a];
+    float speed = q->speed[a], turnProgress = q->turnProgress[a];
+    VehicleHandle handle = q->handles[a];
+    Uint8 flags = q->flags[a], direction = q->direction[a], turnDirection = q->turnDirection[a];
+    Uint8 profile = q->profile[a];
+    Uint32 spawnTime = q->spawnTime[a];
+    Uint16 origin = q->origin[a], destination = q->destination[a];
+
+    moveSlot(q, a, q, b);
+
+    q->x[b] = x;
+    q->y[b] = y;
+    q->dx[b] = dx;
+    q->dy[b] = dy;
+    q->speed[b] = speed;
+    q->turnProgress[b] = turnProgress;
+    q->handles[b] = handle;
+    q->flags[b] = flags;
+    q->direction[b] = direction;
+    q->turnDirection[b] = turnDirection;
+    q->profile[b] = profile;
+    q->spawnTime[b] = spawnTime;
+    q->origin[b] = origin;
+    q->destination[b] = destination;
+
+    if (isHandleLive(q, q->handles[a])) q->slots[q->handles[a].index].position = a;
+    if (isHandleLive(q, q->handles[b])) q->slots[q->handles[b].index].position = b;
+}
+
+// Insertion step: moves the index-th vehicle forward past anyone it has overtaken
+static int bubbleForward(Queue *q, int index, Direction lane) {
+    int swaps = 0;
+    while (index > 0 &&
+           laneProgress(q, QUEUE_SLOT(q, index - 1), lane) < laneProgress(q, QUEUE_SLOT(q, index), lane)) {
+        swapQueueSlots(q, QUEUE_SLOT(q, index - 1), QUEUE_SLOT(q, index));
+        index--;
+        swaps++;
+    }
+
+    // Everyone whose leader changed has to look again
+    for (int i = index; swaps > 0 && i <= index + swaps + 1 && i < q->size; i++) {
+        q->flags[QUEUE_SLOT(q, i)] &= ~VEHICLE_DORMANT;
+    }
+    return swaps;
+}
+
+// Restores FIFO order == spatial order on every lane. Vehicles that finished a turn
+// move to the lane of their new heading; anything else out of place is bubbled back.
+// Returns the number of vehicles that had to be moved.
+int restoreLaneOrder(Intersection *junction) {
+    int repairs = 0;
+
+    for (int lane = 0; lane < 4; lane++) {
+        Queue *q = &junction->lanes[lane];
+        for (int i = 0; i < q->size; i++) {
+            int slot = QUEUE_SLOT(q, i);
+            Uint8 flags = q->flags[slot];
+            if (!(flags & VEHICLE_ACTIVE) || (flags & VEHICLE_TURNING) || q->direction[slot] == lane) {
+                continue;
             }
+
+            Vehicle v;
+            loadSlot(q, slot, &v);
+            VehicleRoute route = {q->origin[slot], q->destination[slot]};
+            removeFromQueue(q, v.handle);
+
+            Queue *target = &junction->lanes[v.direction];
+            enqueueRouted(target, v, route);
+            bubbleForward(target, target->size - 1, (Direction)v.direction);
+            repairs++;
         }
     }
 
-    if (vehicle->y < -50 || vehicle->y > WINDOW_HEIGHT + 50 ||
-        vehicle->x < -50 || vehicle->x > WINDOW_WIDTH + 50) {
-        vehicle->active = false;
+    // Nearly always already sorted, so this is one O(n) check per lane
+    for (int lane = 0; lane < 4; lane++) {
+        Queue *q = &junction->lanes[lane];
+        for (int i = 1; i < q->size; i++) {
+            if (bubbleForward(q, i, (Direction)lane) > 0) {
+                repairs++;
+            }
+        }
     }
 
-    vehicle->rect.x = (int)vehicle->x;
-    vehicle->rect.y = (int)vehicle->y;
+    return repairs;
 }
 
 void renderRoads(SDL_Renderer *renderer) {
@@ -343,7 +568,8 @@ void renderRoads(SDL_Renderer *renderer) {
     }
 }
 
-void renderSimulation(SDL_Renderer *renderer, TrafficLight *lights, Statistics *stats) {
+void renderSimulation(SDL_Renderer *renderer, Intersection *junction) {
+    TrafficLight *lights = junction->lights;
     
     SDL_SetRenderDrawColor(renderer, 50, 205, 50, 255);  // Lime green
     SDL_RenderClear(renderer);
@@ -373,19 +599,19 @@ void renderSimulation(SDL_Renderer *renderer, TrafficLight *lights, Statistics *
 
     // Drawing vehicles from all queues
     for (int lane = 0; lane < 4; lane++) {
-        Node *current = laneQueues[lane].front;
-        while (current != NULL) {
-            Vehicle *v = &current->vehicle;
-            if (v->active) {
-                SDL_Color color = VEHICLE_COLORS[v->colorIndex];
+        Queue *q = &junction->lanes[lane];
+        for (int i = 0; i < q->size; i++) {
+            int slot = QUEUE_SLOT(q, i);
+            if (q->flags[slot] & VEHICLE_ACTIVE) {
+                SDL_Rect rect = vehicleRect(q->x[slot], q->y[slot], (Direction)q->direction[slot]);
+                SDL_Color color = vehicleProfiles[q->profile[slot]].color;
                 SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-                SDL_RenderFillRect(renderer, &v->rect);
+                SDL_RenderFillRect(renderer, &rect);
                 
                 
                 SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-                SDL_RenderDrawRect(renderer, &v->rect);
+                SDL_RenderDrawRect(renderer, &rect);
             }
-            current = current->next;
         }
     }
 
@@ -394,48 +620,243 @@ void renderSimulation(SDL_Renderer *renderer, TrafficLight *lights, Statistics *
 
 // Queue functions
 void initQueue(Queue *q) {
-    q->front = q->rear = NULL;
+    q->x = q->y = q->speed = q->turnProgress = NULL;
+    q->flags = q->direction = q->turnDirection = NULL;
+    q->profile = NULL;
+    q->spawnTime = NULL;
+    q->origin = q->destination = NULL;
+    q->handles = NULL;
+    q->storage = NULL;
+    q->capacity = 0;
+    q->head = 0;
     q->size = 0;
+    q->slots = NULL;
+    q->freeSlot = -1;
+    q->wakeList = NULL;
+    SDL_AtomicSet(&q->wakeCount, 0);
 }
 
-void enqueue(Queue *q, Vehicle vehicle) {
-    Node *newNode = (Node *)malloc(sizeof(Node));
-    newNode->vehicle = vehicle;
-    newNode->next = NULL;
-    
-    if (q->rear == NULL) {
-        q->front = q->rear = newNode;
-    } else {
-        q->rear->next = newNode;
-        q->rear = newNode;
+// Carves every column out of one block: floats, handles, spawn times, the wake list,
+// origins and destinations, then bytes
+static size_t columnBytes(int capacity) {
+    return capacity * (7 * sizeof(float) + sizeof(VehicleHandle) + sizeof(Uint32) + sizeof(int) +
+                       2 * sizeof(Uint16) + 5 * sizeof(Uint8));
+}
+
+static void assignColumns(Queue *q, void *storage, int capacity) {
+    float *floats = (float *)storage;
+    q->x = floats;
+    q->y = floats + capacity;
+    q->dx = floats + capacity * 2;
+    q->dy = floats + capacity * 3;
+    q->speed = floats + capacity * 4;
+    q->turnProgress = floats + capacity * 5;
+    q->lastProgress = floats + capacity * 6;
+    q->handles = (VehicleHandle *)(floats + capacity * 7);
+    q->spawnTime = (Uint32 *)(q->handles + capacity);
+    q->wakeList = (int *)(q->spawnTime + capacity);
+    q->origin = (Uint16 *)(q->wakeList + capacity);
+    q->destination = q->origin + capacity;
+    Uint8 *bytes = (Uint8 *)(q->destination + capacity);
+    q->flags = bytes;
+    q->direction = bytes + capacity;
+    q->turnDirection = bytes + capacity * 2;
+    q->profile = bytes + capacity * 3;
+    q->lastFlags = bytes + capacity * 4;
+    q->storage = storage;
+    q->capacity = capacity;
+}
+
+static void moveSlot(Queue *dst, int to, const Queue *src, int from) {
+    dst->x[to] = src->x[from];
+    dst->y[to] = src->y[from];
+    dst->dx[to] = src->dx[from];
+    dst->dy[to] = src->dy[from];
+    dst->speed[to] = src->speed[from];
+    dst->turnProgress[to] = src->turnProgress[from];
+    dst->handles[to] = src->handles[from];
+    dst->flags[to] = src->flags[from];
+    dst->direction[to] = src->direction[from];
+    dst->turnDirection[to] = src->turnDirection[from];
+    dst->profile[to] = src->profile[from];
+    dst->spawnTime[to] = src->spawnTime[from];
+    dst->origin[to] = src->origin[from];
+    dst->destination[to] = src->destination[from];
+}
+
+static void growQueue(Queue *q) {
+    int newCapacity = q->capacity ? q->capacity * 2 : QUEUE_INITIAL_CAPACITY;
+    Queue grown;
+    assignColumns(&grown, simAlloc(columnBytes(newCapacity)), newCapacity);
+    HandleSlot *slots = (HandleSlot *)simAlloc(sizeof(HandleSlot) * newCapacity);
+
+    for (int i = 0; i < q->capacity; i++) {
+        slots[i] = q->slots[i];
+    }
+
+    // New slots go on the free list, lowest index first
+    for (int i = newCapacity - 1; i >= q->capacity; i--) {
+        slots[i].position = -1;
+        slots[i].generation = 0;
+        slots[i].nextFree = q->freeSlot;
+        q->freeSlot = i;
     }
+
+    // Unwrap the ring so the front lands at index 0
+    for (int i = 0; i < q->size; i++) {
+        moveSlot(&grown, i, q, QUEUE_SLOT(q, i));
+        VehicleHandle handle = grown.handles[i];
+        if (slots[handle.index].generation == handle.generation) {
+            slots[handle.index].position = i;
+        }
+    }
+
+    simFree(q->storage);
+    simFree(q->slots);
+    assignColumns(q, grown.storage, newCapacity);
+    q->slots = slots;
+    q->head = 0;
+}
+
+static bool isHandleLive(Queue *q, VehicleHandle handle) {
+    return handle.index < (Uint32)q->capacity &&
+           q->slots[handle.index].position >= 0 &&
+           q->slots[handle.index].generation == handle.generation;
+}
+
+static void releaseHandle(Queue *q, VehicleHandle handle) {
+    HandleSlot *slot = &q->slots[handle.index];
+    slot->position = -1;
+    slot->generation++;
+    slot->nextFree = q->freeSlot;
+    q->freeSlot = handle.index;
+}
+
+static void loadSlot(Queue *q, int slot, Vehicle *vehicle) {
+    loadHot(q, slot, vehicle);
+    vehicle->profile = q->profile[slot];
+    vehicle->spawnTime = q->spawnTime[slot];
+    vehicle->handle = q->handles[slot];
+}
+
+static void storeSlot(Queue *q, int slot, const Vehicle *vehicle) {
+    storeHot(q, slot, vehicle);
+    q->profile[slot] = vehicle->profile;
+    q->spawnTime[slot] = vehicle->spawnTime;
+}
+
+VehicleHandle enqueue(Queue *q, Vehicle vehicle) {
+    return enqueueRouted(q, vehicle, NO_ROUTE);
+}
+
+VehicleHandle enqueueRouted(Queue *q, Vehicle vehicle, VehicleRoute route) {
+    if (q->size == q->capacity) {
+        growQueue(q);
+    }
+
+    int position = QUEUE_SLOT(q, q->size);
+    int index = q->freeSlot;
+    q->freeSlot = q->slots[index].nextFree;
+    q->slots[index].position = position;
+
+    VehicleHandle handle = {(Uint32)index, q->slots[index].generation};
+    storeSlot(q, position, &vehicle);
+    q->origin[position] = route.origin;
+    q->destination[position] = route.destination;
+    q->handles[position] = handle;
     q->size++;
+
+    return handle;
 }
 
 Vehicle dequeue(Queue *q) {
-    if (q->front == NULL) {
-        Vehicle empty = {0};
+    if (q->size == 0) {
+        Vehicle empty = {};
         return empty;
     }
-    
-    Node *temp = q->front;
-    Vehicle vehicle = temp->vehicle;
-    
-    q->front = q->front->next;
-    if (q->front == NULL) {
-        q->rear = NULL;
+
+    Vehicle vehicle;
+    loadSlot(q, q->head, &vehicle);
+    if (isHandleLive(q, vehicle.handle)) {
+        releaseHandle(q, vehicle.handle);
     }
-    
-    free(temp);
+    q->head = (q->head + 1) & (q->capacity - 1);
     q->size--;
-    
+
     return vehicle;
 }
 
 int isQueueEmpty(Queue *q) {
-    return q->front == NULL;
+    return q->size == 0;
 }
 
-void removeFromQueue(Queue *q, Vehicle *vehicle) {
+Vehicle queueLoad(Queue *q, int index) {
+    Vehicle vehicle;
+    loadSlot(q, QUEUE_SLOT(q, index), &vehicle);
+    return vehicle;
+}
+
+// Writes everything but the handle, which stays owned by the queue
+void queueStore(Queue *q, int index, const Vehicle *vehicle) {
+    storeSlot(q, QUEUE_SLOT(q, index), vehicle);
+}
+
+// Grows the columns up front so the first capacity vehicles never allocate
+void reserveQueue(Queue *q, int capacity) {
+    while (q->capacity < capacity) {
+        growQueue(q);
+    }
+}
+
+void freeQueue(Queue *q) {
+    simFree(q->storage);
+    simFree(q->slots);
+    initQueue(q);
+}
+
+bool queueGet(Queue *q, VehicleHandle handle, Vehicle *vehicle) {
+    if (!isHandleLive(q, handle)) {
+        return false;
+    }
+    loadSlot(q, q->slots[handle.index].position, vehicle);
+    return true;
+}
+
+// O(1): the vehicle is left behind as an inactive tombstone for compactQueue
+bool removeFromQueue(Queue *q, VehicleHandle handle) {
+    if (!isHandleLive(q, handle)) {
+        return false;
+    }
+
+    q->flags[q->slots[handle.index].position] &= ~VEHICLE_ACTIVE;
+    releaseHandle(q, handle);
+    return true;
+}
+
+// Drops every inactive vehicle in one pass, keeping FIFO order; returns how many
+int compactQueue(Queue *q) {
+    int kept = 0;
 
-}
\ No newline at end of file
+    for (int i = 0; i < q->size; i++) {
+        int slot = QUEUE_SLOT(q, i);
+        VehicleHandle handle = q->handles[slot];
+
+        if (!(q->flags[slot] & VEHICLE_ACTIVE)) {
+            if (isHandleLive(q, handle)) {
+                releaseHandle(q, handle);
+            }
+            continue;
+        }
+
+        int position = QUEUE_SLOT(q, kept);
+        if (kept != i) {
+            moveSlot(q, position, q, slot);
+        }
+        q->slots[handle.index].position = position;
+        kept++;
+    }
+
+    int removed = q->size - kept;
+    q->size = kept;
+    return removed;
+}
@@ -3,19 +3,46 @@
 
 #include <SDL2/SDL.h>
 #include <stdbool.h>
+#include "pool.h"
+#include "priority_queue.h"
+#include "rng.h"
 
 // Window and lane configuration
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
 #define LANE_WIDTH 80
 #define MAX_VEHICLES 100
+// Junction centre in tile-local coordinates: every junction in a network is one
+// window-sized tile with the same layout
 #define INTERSECTION_X (WINDOW_WIDTH / 2)
 #define INTERSECTION_Y (WINDOW_HEIGHT / 2)
 
+// Share of vehicles that turn left at each junction
+#define LEFT_TURN_PERCENT 15
+
+// Parallel lane update: vehicles per task, and the total below which waking workers costs more than it saves
+#define LANE_CHUNK_VEHICLES 256
+#define LANE_PARALLEL_MIN_VEHICLES 1024
+
+// Fixed simulation step. Per-step constants (speeds, acceleration, turn rate) are tuned for it.
+#define SIM_STEP_MS 16
+
+// Time-warp limits (simulated seconds per wall second) and spiral-of-death guard
+#define SIM_WARP_MIN 1.0f
+#define SIM_WARP_MAX 1000.0f
+#define SIM_MAX_STEPS_PER_FRAME 2000
+
+// Event logging, switched off for headless batch runs
+#define SIM_LOG(...) do { if (simulationVerbose) printf(__VA_ARGS__); } while (0)
+
 // Traffic light dimensions
 #define TRAFFIC_LIGHT_WIDTH (LANE_WIDTH * 2)
 #define TRAFFIC_LIGHT_HEIGHT 15
 
+// Signal timing: phase length and how many queued vehicles one second of red is worth
+#define SIGNAL_PHASE_MS 5000
+#define SIGNAL_WAIT_WEIGHT 0.5f
+
 // Direction enumeration
 typedef enum {
     DIRECTION_NORTH = 0,
@@ -48,30 +75,92 @@ typedef enum {
     GREEN
 } TrafficLightState;
 
-// Vehicle structure
+// Approaches on the same axis share a signal phase
+typedef enum {
+    AXIS_NORTH_SOUTH,
+    AXIS_EAST_WEST
+} Axis;
+
+// Red-light window around the stop line, in progress along the lane
+#define STOP_WINDOW_BEFORE 10
+#define STOP_WINDOW_AFTER 80
+
+// Everything that differs between approaches, indexed by Direction, so lane code
+// loads from here instead of switching on direction. Progress along an approach is
+// x * headingX + y * headingY, so "has reached a line" is always progress >= line.
+// Positions are the top-left corner of the vehicle rect, as everywhere else.
+typedef struct {
+    const char* name;
+    float entryX, entryY;       // Spawn point, just off screen
+    float headingX, headingY;   // Unit direction of travel
+    float stopLine;             // Progress of the stop line
+    float centerLine;           // Progress of the intersection centre
+    float exitLine;             // Progress past which the vehicle is off screen
+    float turnX, turnY;         // Where a left turn starts: the lane's line at the centre
+    Direction leftTurnExit;     // Direction a left turn leaves in
+    Axis axis;
+    int width, height;          // Vehicle rect while on this approach
+    SDL_Rect light;             // Where its traffic light is drawn
+} ApproachGeometry;
+
+// Stable vehicle handle (slot index plus generation), survives queue compaction
+typedef struct {
+    Uint32 index;
+    Uint32 generation;
+} VehicleHandle;
+
+// Per-vehicle flag bits
+#define VEHICLE_ACTIVE        0x01
+#define VEHICLE_STOPPED       0x02
+#define VEHICLE_TURNING       0x04
+#define VEHICLE_PASSED_CENTER 0x08
+#define VEHICLE_BLOCKED       0x10
+#define VEHICLE_DORMANT       0x20  // Held behind a stopped leader: skipped until woken
+
+// Cold per-vehicle attributes, shared through the profile side table
 typedef struct {
-    SDL_Rect rect;
     VehicleType type;
-    Direction direction;
-    TurnDirection turnDirection;
-    VehicleState state;
-    float speed;
+    SDL_Color color;
+} VehicleProfile;
+
+#define VEHICLE_PROFILE_COUNT 8
+extern const VehicleProfile vehicleProfiles[VEHICLE_PROFILE_COUNT];
+
+// Vehicle structure, 32 bytes so two fit in a cache line.
+// The on-screen rect is derived from position and heading when rendering.
+typedef struct {
     float x;
     float y;
-    bool active;
-    int colorIndex;
-    bool shouldStopForVehicle;
-    bool isTurning;
+    float speed;
     float turnProgress;
-    bool hasPassedCenter;
+    VehicleHandle handle;
+    Uint32 spawnTime;     // Simulated ms at which the vehicle enters its lane
+    Uint8 direction;      // Direction
+    Uint8 turnDirection;  // TurnDirection
+    Uint8 flags;          // VEHICLE_* bits
+    Uint8 profile;        // Index into vehicleProfiles
 } Vehicle;
 
+static_assert(sizeof(Vehicle) == 32, "Vehicle should stay at half a cache line");
+
+// Where a vehicle following a route (see route_cache.h) entered the network and where
+// it leaves it. Cold, so it lives in its own lane columns rather than in Vehicle.
+#define VEHICLE_NO_ROUTE 0xFFFF
+
+typedef struct {
+    Uint16 origin;
+    Uint16 destination;
+} VehicleRoute;
+
+extern const VehicleRoute NO_ROUTE;
+
 // Traffic light structure
 typedef struct {
     TrafficLightState state;
-    int timer;
+    int timer;          // Simulated ms spent in the current phase
     SDL_Rect position;
     Direction direction;
+    Uint32 redSince;
 } TrafficLight;
 
 // Statistics structure
@@ -80,44 +169,137 @@ typedef struct {
     int totalVehicles;
     float vehiclesPerMinute;
     Uint32 startTime;
+    int laneDropped[4];
+    int laneRetries[4];
 } Statistics;
 
-// Queue node structure
-typedef struct Node {
-    Vehicle vehicle;
-    struct Node* next;
-} Node;
+// Queue structure (growable ring buffer, capacity is always a power of two)
+#define QUEUE_INITIAL_CAPACITY 16
+
+// Handle slot: ring position of a live vehicle, or a link in the free list
+typedef struct {
+    int position;
+    Uint32 generation;
+    int nextFree;
+} HandleSlot;
 
-// Queue structure
+// Lane storage is structure-of-arrays: one column per field, all indexed by ring slot.
+// Vehicle is only the copy type used to move records in and out.
 typedef struct {
-    Node* front;
-    Node* rear;
+    // Hot columns, touched every tick
+    float* x;
+    float* y;
+    float* dx;              // Unit heading, kept in step with direction for the motion kernel
+    float* dy;
+    float* speed;
+    float* turnProgress;
+    Uint8* flags;
+    Uint8* direction;
+    Uint8* turnDirection;
+    // Cold columns
+    Uint8* profile;
+    Uint32* spawnTime;
+    Uint16* origin;
+    Uint16* destination;
+    VehicleHandle* handles;
+    // Previous-tick state, refreshed by snapshotLane. Followers only look at their
+    // leader through it, so a lane's vehicles can be updated in any order or in parallel.
+    float* lastProgress;
+    Uint8* lastFlags;
+    // Ring slots of followers whose leader restarted this tick, cleared by wakeFollowers
+    int* wakeList;
+    SDL_atomic_t wakeCount;
+    void* storage;
+    int capacity;
+    int head;
     int size;
+    HandleSlot* slots;
+    int freeSlot;
 } Queue;
 
-// Global lane queues
-extern Queue laneQueues[4];
+// Ring slot of the index-th vehicle from the front
+#define QUEUE_SLOT(q, index) (((q)->head + (index)) & ((q)->capacity - 1))
+
+// Simulation clock: simulated time only ever moves in fixed steps of stepMs.
+// Wall time scaled by warp accumulates in pendingMs and is paid out in whole steps,
+// so any warp factor produces the same sequence of steps.
+typedef struct {
+    Uint32 time;        // Simulated ms since start
+    Uint32 stepMs;
+    float warp;
+    double pendingMs;
+} SimulationClock;
+
+// Random streams, all split from one seed so a run can be replayed exactly.
+// Vehicle attributes come from the stream of the lane they enter, so results
+// don't depend on which thread creates which vehicle.
+#define RNG_STREAM_INTERSECTION 0
+#define RNG_STREAM_LANE(lane) (1 + (lane))
+#define RNG_STREAM_JUNCTION(index) (5 + (index))
+
+typedef struct {
+    Uint64 seed;
+    Rng intersection;  // Which approach each arrival uses
+    Rng lanes[4];      // Turn intention and profile of vehicles entering each lane
+} SimulationRandom;
+
+// Simulation clock and logging
+extern SimulationClock simulationClock;
+extern bool simulationVerbose;
+void initSimulationClock(SimulationClock* clock, Uint32 stepMs, float warp);
+int accumulateWallTime(SimulationClock* clock, double wallMs);
+void tickSimulationClock(SimulationClock* clock);
+Uint32 getSimulationTime(void);
+
+// Random streams
+extern SimulationRandom simulationRandom;
+void seedSimulationRandom(SimulationRandom* random, Uint64 seed);
+
+// A signalised junction with its own lanes and lights (see network.h)
+typedef struct Intersection Intersection;
+
+// Pool backing every Vehicle handed out by createVehicle. Only the generator makes
+// standalone vehicles; the simulator keeps its vehicles in lane columns.
+extern Pool vehiclePool;
 
 // Traffic light functions
-void initializeTrafficLights(TrafficLight* lights);
-void updateTrafficLights(TrafficLight* lights);
+void initializeTrafficLights(Intersection* junction);
+void updateTrafficLights(Intersection* junction);
+
+// Approach geometry
+extern const ApproachGeometry APPROACHES[4];
 
 // Vehicle functions
+void initVehicle(Vehicle* vehicle, Direction direction);
 Vehicle* createVehicle(Direction direction);
+void freeVehicle(Vehicle* vehicle);
 void updateVehicle(Vehicle *vehicle, TrafficLight *lights);
+void snapshotLane(Queue* q, Direction lane);
+int updateLaneRange(Intersection* junction, Direction lane, int begin, int end);
+int updateLane(Intersection* junction, Direction lane);
+void wakeFollowers(Queue* q);
 
 // Collision detection
-bool shouldStopForVehicleInQueue(Vehicle *vehicle, Direction lane);
+bool shouldStopForVehicleInQueue(Queue* q, int index);
+int restoreLaneOrder(Intersection* junction);
 
 // Rendering functions
-void renderSimulation(SDL_Renderer* renderer, TrafficLight* lights, Statistics* stats);
+SDL_Rect vehicleRect(float x, float y, Direction direction);
+void renderSimulation(SDL_Renderer* renderer, Intersection* junction);
 void renderRoads(SDL_Renderer* renderer);
 
 // Queue functions
 void initQueue(Queue* q);
-void enqueue(Queue* q, Vehicle vehicle);
+VehicleHandle enqueue(Queue* q, Vehicle vehicle);
+VehicleHandle enqueueRouted(Queue* q, Vehicle vehicle, VehicleRoute route);
 Vehicle dequeue(Queue* q);
 int isQueueEmpty(Queue* q);
-void removeFromQueue(Queue* q, Vehicle* vehicle);
+Vehicle queueLoad(Queue* q, int index);
+void queueStore(Queue* q, int index, const Vehicle* vehicle);
+void reserveQueue(Queue* q, int capacity);
+void freeQueue(Queue* q);
+bool queueGet(Queue* q, VehicleHandle handle, Vehicle* vehicle);
+bool removeFromQueue(Queue* q, VehicleHandle handle);
+int compactQueue(Queue* q);
 
 #endif 
\ No newline at end of file
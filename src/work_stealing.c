@@ -0,0 +1,126 @@
+#include "work_stealing.h"
+
+void initJunctionScheduler(JunctionScheduler *scheduler, Network *network) {
+    scheduler->network = network;
+    scheduler->workerCount = 0;
+    scheduler->steals = 0;
+    SDL_AtomicSet(&scheduler->unfinished, 0);
+    scheduler->lanesPending = (SDL_atomic_t *)simAlloc(sizeof(SDL_atomic_t) * network->count);
+    for (int w = 0; w <= WORKER_POOL_MAX_THREADS; w++) {
+        scheduler->workers[w].deque.clear();
+        scheduler->workers[w].nextSeed = scheduler->workers[w].endSeed = 0;
+        scheduler->workers[w].victim = 0;
+    }
+}
+
+void freeJunctionScheduler(JunctionScheduler *scheduler) {
+    simFree(scheduler->lanesPending);
+    scheduler->lanesPending = NULL;
+}
+
+// Owner side. Pushed last to first, so the owner works forwards through its run
+// while thieves take from the far end.
+static bool pushSeeds(StealWorker *worker) {
+    int room = STEAL_DEQUE_CAPACITY - (int)worker->deque.size();
+    int count = worker->endSeed - worker->nextSeed < room ? worker->endSeed - worker->nextSeed : room;
+    if (count <= 0) return false;
+
+    for (int j = worker->nextSeed + count - 1; j >= worker->nextSeed; j--) {
+        worker->deque.push(MAKE_TASK(j, TASK_JUNCTION));
+    }
+    worker->nextSeed += count;
+    return true;
+}
+
+// Junctions [first, end) start in this worker's deque. Only call between steps.
+void seedJunctionTasks(JunctionScheduler *scheduler, int worker, int first, int end) {
+    StealWorker *self = &scheduler->workers[worker];
+    self->nextSeed = first;
+    self->endSeed = end;
+    self->left = 0;
+    self->steals = 0;
+    pushSeeds(self);
+}
+
+static void runTask(JunctionScheduler *scheduler, StealWorker *self, int task) {
+    int index = task / 8;
+    int kind = task % 8;
+    Intersection *junction = &scheduler->network->junctions[index];
+
+    if (kind == TASK_JUNCTION) {
+        prepareJunction(junction);
+
+        int vehicles = 0;
+        for (int lane = 0; lane < 4; lane++) {
+            vehicles += junction->lanes[lane].size;
+        }
+        if (vehicles >= JUNCTION_SPLIT_VEHICLES) {
+            SDL_AtomicSet(&scheduler->lanesPending[index], 4);
+            for (int lane = 3; lane > 0; lane--) {
+                int laneTask = MAKE_TASK(index, TASK_LANE + lane);
+                if (!self->deque.push(laneTask)) {
+                    runTask(scheduler, self, laneTask);
+                }
+            }
+            runTask(scheduler, self, MAKE_TASK(index, TASK_LANE));
+            return;
+        }
+
+        for (int lane = 0; lane < 4; lane++) {
+            updateJunctionLane(junction, (Direction)lane);
+        }
+    } else {
+        updateJunctionLane(junction, (Direction)(kind - TASK_LANE));
+        // The atomic orders the other lanes' updates before the last one carries on
+        if (SDL_AtomicAdd(&scheduler->lanesPending[index], -1) != 1) return;
+    }
+
+    restoreLaneOrder(junction);
+    self->left += handOffJunctionExits(junction);
+    SDL_AtomicAdd(&scheduler->unfinished, -1);
+}
+
+static bool stealTask(JunctionScheduler *scheduler, int worker, int *task) {
+    StealWorker *self = &scheduler->workers[worker];
+    for (int i = 1; i < scheduler->workerCount; i++) {
+        self->victim = self->victim % (scheduler->workerCount - 1) + 1;
+        StealWorker *victim = &scheduler->workers[(worker + self->victim) % scheduler->workerCount];
+        if (victim->deque.steal(*task)) {
+            self->steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void runWorker(void *context, int worker) {
+    JunctionScheduler *scheduler = (JunctionScheduler *)context;
+    StealWorker *self = &scheduler->workers[worker];
+    int task;
+
+    while (SDL_AtomicGet(&scheduler->unfinished) > 0) {
+        if (self->deque.pop(task) || (pushSeeds(self) && self->deque.pop(task)) ||
+            stealTask(scheduler, worker, &task)) {
+            runTask(scheduler, self, task);
+        } else {
+            // What's left is running on other workers
+            SDL_Delay(0);
+        }
+    }
+}
+
+// Updates every junction and hands its exits on; returns how many vehicles left the
+// network. Every worker must have been seeded, and every junction exactly once.
+// One job index per worker, so each deque has exactly one owner thread.
+int runJunctionTasks(JunctionScheduler *scheduler, WorkerPool *workers, int workerCount) {
+    scheduler->workerCount = workerCount;
+    SDL_AtomicSet(&scheduler->unfinished, scheduler->network->count);
+    runParallel(workers, runWorker, scheduler, workerCount);
+
+    int left = 0;
+    for (int w = 0; w < workerCount; w++) {
+        left += scheduler->workers[w].left;
+        scheduler->steals += scheduler->workers[w].steals;
+    }
+    return left;
+}
@@ -0,0 +1,47 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include "network.h"
+#include "worker_pool.h"
+#include "queue.hpp"
+
+#define STEAL_DEQUE_CAPACITY 2048     // Tasks per worker, must be a power of two
+#define JUNCTION_SPLIT_VEHICLES 256   // A junction this busy updates its lanes as separate tasks
+
+// A task is a junction index times 8 plus TASK_JUNCTION, or plus TASK_LANE + lane
+#define TASK_JUNCTION 0
+#define TASK_LANE 1
+#define MAKE_TASK(junction, kind) ((junction) * 8 + (kind))
+
+typedef sim::Queue<int, STEAL_DEQUE_CAPACITY, sim::FixedCapacity, sim::ChaseLev> TaskDeque;
+
+typedef struct {
+    TaskDeque deque;
+    int nextSeed, endSeed;  // Own junctions that didn't fit in the deque yet
+    int victim;             // Offset of the next worker to steal from
+    int left;               // Vehicles that left the network this step
+    int steals;             // Tasks taken from other workers this step
+} StealWorker;
+
+// Junction updates for one step on a Chase-Lev deque per worker. Each worker is seeded
+// with a run of junctions, pops its newest task and, once it runs dry, steals the oldest
+// task of another worker. A junction with JUNCTION_SPLIT_VEHICLES or more vehicles is
+// prepared by its own task and then split into one task per lane; the last lane to
+// finish restores the lane order and hands its exits on, as an unsplit junction does.
+// The deques are cache-line aligned, so keep this in static storage.
+typedef struct {
+    Network* network;
+    StealWorker workers[WORKER_POOL_MAX_THREADS + 1];
+    int workerCount;
+    SDL_atomic_t unfinished;     // Junctions not yet handed on this step
+    SDL_atomic_t* lanesPending;  // Per junction: lane tasks still running
+    unsigned long steals;        // Over the whole run
+} JunctionScheduler;
+
+// Work-stealing scheduler functions
+void initJunctionScheduler(JunctionScheduler* scheduler, Network* network);
+void freeJunctionScheduler(JunctionScheduler* scheduler);
+void seedJunctionTasks(JunctionScheduler* scheduler, int worker, int first, int end);
+int runJunctionTasks(JunctionScheduler* scheduler, WorkerPool* workers, int workerCount);
+
+#endif
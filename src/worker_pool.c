@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include "worker_pool.h"
+
+static void drainTasks(SDL_atomic_t *next, WorkerTask task, void *context, int count) {
+    int index;
+    while ((index = SDL_AtomicAdd(next, 1)) < count) {
+        task(context, index);
+    }
+}
+
+static int workerThread(void *data) {
+    WorkerPool *pool = (WorkerPool *)data;
+    Uint32 seen = 0;
+
+    SDL_LockMutex(pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->stopping) {
+            SDL_CondWait(pool->wake, pool->lock);
+        }
+        if (pool->stopping) break;
+
+        // Copy the job while holding the lock; the next one can't be posted until busy drops to 0
+        seen = pool->generation;
+        WorkerTask task = pool->task;
+        void *context = pool->context;
+        int count = pool->count;
+        pool->busy++;
+        SDL_UnlockMutex(pool->lock);
+
+        drainTasks(&pool->next, task, context, count);
+
+        SDL_LockMutex(pool->lock);
+        if (--pool->busy == 0) {
+            SDL_CondBroadcast(pool->idle);
+        }
+    }
+    SDL_UnlockMutex(pool->lock);
+    return 0;
+}
+
+// threads counts the calling thread, so 1 runs every job inline
+bool startWorkerPool(WorkerPool *pool, int threads) {
+    if (threads < 1) threads = 1;
+    if (threads > WORKER_POOL_MAX_THREADS + 1) threads = WORKER_POOL_MAX_THREADS + 1;
+
+    pool->threadCount = 0;
+    pool->generation = 0;
+    pool->busy = 0;
+    pool->stopping = false;
+    pool->task = NULL;
+    pool->context = NULL;
+    pool->count = 0;
+    SDL_AtomicSet(&pool->next, 0);
+
+    pool->lock = SDL_CreateMutex();
+    pool->wake = SDL_CreateCond();
+    pool->idle = SDL_CreateCond();
+    if (!pool->lock || !pool->wake || !pool->idle) {
+        printf("Failed to create worker pool: %s\n", SDL_GetError());
+        return false;
+    }
+
+    for (int i = 0; i < threads - 1; i++) {
+        SDL_Thread *thread = SDL_CreateThread(workerThread, "lane worker", pool);
+        if (!thread) {
+            // Run with however many workers did start
+            printf("Failed to start lane worker: %s\n", SDL_GetError());
+            break;
+        }
+        pool->threads[pool->threadCount++] = thread;
+    }
+
+    return true;
+}
+
+void runParallel(WorkerPool *pool, WorkerTask task, void *context, int count) {
+    if (pool->threadCount == 0 || count <= 1) {
+        for (int i = 0; i < count; i++) {
+            task(context, i);
+        }
+        return;
+    }
+
+    SDL_LockMutex(pool->lock);
+    // A late worker may still be leaving the previous job
+    while (pool->busy > 0) {
+        SDL_CondWait(pool->idle, pool->lock);
+    }
+    pool->task = task;
+    pool->context = context;
+    pool->count = count;
+    SDL_AtomicSet(&pool->next, 0);
+    pool->generation++;
+    SDL_CondBroadcast(pool->wake);
+    SDL_UnlockMutex(pool->lock);
+
+    drainTasks(&pool->next, task, context, count);
+
+    // Every index is claimed; wait for the workers still running theirs
+    SDL_LockMutex(pool->lock);
+    while (pool->busy > 0) {
+        SDL_CondWait(pool->idle, pool->lock);
+    }
+    SDL_UnlockMutex(pool->lock);
+}
+
+void stopWorkerPool(WorkerPool *pool) {
+    SDL_LockMutex(pool->lock);
+    pool->stopping = true;
+    SDL_CondBroadcast(pool->wake);
+    SDL_UnlockMutex(pool->lock);
+
+    for (int i = 0; i < pool->threadCount; i++) {
+        SDL_WaitThread(pool->threads[i], NULL);
+    }
+    pool->threadCount = 0;
+
+    SDL_DestroyCond(pool->idle);
+    SDL_DestroyCond(pool->wake);
+    SDL_DestroyMutex(pool->lock);
+}
@@ -0,0 +1,35 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+#define WORKER_POOL_MAX_THREADS 64
+
+// One parallel job: task(context, index) runs once for every index in [0, count)
+typedef void (*WorkerTask)(void* context, int index);
+
+// Persistent worker threads, started once and parked on a condition variable between jobs.
+// runParallel hands out indices through an atomic counter, the calling thread takes
+// indices too, and it returns only when every index has finished: that is the barrier.
+typedef struct {
+    SDL_Thread* threads[WORKER_POOL_MAX_THREADS];
+    int threadCount;       // Workers besides the calling thread
+    SDL_mutex* lock;
+    SDL_cond* wake;        // A job was posted or the pool is stopping
+    SDL_cond* idle;        // The last busy worker went back to waiting
+    Uint32 generation;     // Bumped per job so parked workers notice it
+    int busy;              // Workers currently inside a job
+    bool stopping;
+    WorkerTask task;
+    void* context;
+    int count;
+    SDL_atomic_t next;     // Next unclaimed index
+} WorkerPool;
+
+// Worker pool functions
+bool startWorkerPool(WorkerPool* pool, int threads);
+void runParallel(WorkerPool* pool, WorkerTask task, void* context, int count);
+void stopWorkerPool(WorkerPool* pool);
+
+#endif